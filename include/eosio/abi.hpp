@@ -1,9 +1,14 @@
 #pragma once
 
+#include "field_index.hpp"
 #include "name.hpp"
 #include "types.hpp"
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <variant>
 #include <vector>
@@ -27,7 +32,8 @@ enum class abi_error {
    redefined_type,
    base_not_a_struct,
    extension_typedef,
-   bad_abi
+   bad_abi,
+   bad_projection
 };
 
 constexpr inline std::string_view convert_abi_error(eosio::abi_error e) {
@@ -41,6 +47,7 @@ constexpr inline std::string_view convert_abi_error(eosio::abi_error e) {
       case abi_error::base_not_a_struct: return "Base not a struct";
       case abi_error::extension_typedef: return "Extension typedef";
       case abi_error::bad_abi: return "Bad ABI";
+      case abi_error::bad_projection: return "Bad projection";
       default: return "internal failure";
    };
 }
@@ -177,6 +184,49 @@ struct abi_type;
 struct abi_field {
    std::string     name;
    const abi_type* type;
+   // "name": as json, escaped once when the field is resolved
+   std::string     json_key;
+
+   abi_field(std::string name, const abi_type* type);
+};
+
+// One instruction of an abi_program. Structs, optionals, extensions and arrays of builtins are compiled inline
+// into the program of the type using them; other arrays, variants and recursive structs run their own program.
+struct abi_op {
+   enum code_t : uint8_t {
+      builtin,      // a value converted by type->ser
+      call,         // a value converted by type's own program
+      begin_object, // type's '{'
+      key,          // the key of field; the instructions of its value follow
+      fixed,        // count fields from field on, all fixed-size builtins, size bytes in binary
+      end_object,
+      optional,     // the presence flag; the instructions of the value follow
+      array,        // an array of type; its elements are converted in one loop when they are builtins
+      variant,      // a variant of type
+   };
+
+   code_t           code  = builtin;
+   // Whether extensions may be omitted here, given they may be for the whole program: each enclosing struct
+   // is the last field of the next one out
+   bool             allow = false;
+   // key, fixed: whether field is the struct's first. array: whether its elements are builtins or fixed-layout
+   // structs, which are converted in one loop.
+   bool             first = false;
+   // key, optional: the number of instructions of the value which follows
+   uint32_t         skip  = 0;
+   // key: the distance to the instruction after the struct's end_object
+   uint32_t         end   = 0;
+   const abi_type*  type  = nullptr;
+   const abi_field* field = nullptr;
+   // fixed: the number of fields
+   uint32_t         count = 0;
+   // fixed: the size of the fields in binary. array: the size of each element, if it is fixed.
+   uint32_t         size  = 0;
+};
+
+// The instructions which convert a value of one type, run by abieos' bin_to_json and json_to_bin
+struct abi_program {
+   std::vector<abi_op> ops;
 };
 
 struct abi_type {
@@ -199,13 +249,62 @@ struct abi_type {
    struct struct_ {
       abi_type*              base = nullptr;
       std::vector<abi_field> fields;
+      // Finds fields by name. Filled by index_fields once fields are complete.
+      field_index            index{};
+
+      void index_fields() {
+         index.build(fields.size(), [&](uint32_t i) -> std::string_view { return fields[i].name; });
+      }
+
+      // Calls f with the index of each field named name
+      template <typename F>
+      void find_fields(std::string_view name, F&& f) const {
+         if (index.empty()) {
+            for (uint32_t i = 0; i < fields.size(); ++i)
+               if (fields[i].name == name)
+                  f(i);
+            return;
+         }
+         index.for_each(name, [&](uint32_t i) -> std::string_view { return fields[i].name; }, f);
+      }
+   };
+   // The alternatives of a variant, which json names by type
+   struct variant : std::vector<abi_field> {
+      // Finds alternatives by name. Filled by index_alternatives once the alternatives are complete.
+      field_index index;
+
+      void index_alternatives() {
+         index.build(size(), [&](uint32_t i) -> std::string_view { return (*this)[i].name; });
+      }
+
+      // Returns the first alternative named name, or nullptr
+      const abi_field* find(std::string_view name) const {
+         if (index.empty()) {
+            for (auto& field : *this)
+               if (field.name == name)
+                  return &field;
+            return nullptr;
+         }
+         auto i = index.find(name, [&](uint32_t i) -> std::string_view { return (*this)[i].name; });
+         return i == field_index::npos ? nullptr : &(*this)[i];
+      }
    };
-   using variant = std::vector<abi_field>;
    std::variant<builtin, const alias_def*, const struct_def*, const variant_def*, alias, optional, extension, array,
                 struct_, variant>
                          _data;
    const abi_serializer* ser = nullptr;
 
+   // The size in binary of every value of a builtin type, or 0 if it varies
+   uint32_t fixed_size = 0;
+
+   // Set on types of lazily converted abis (see convert_lazy) once the type and every type it depends on are
+   // resolved. Resolved types never change again.
+   std::atomic<bool> resolved{ false };
+
+   // Compiled by program()
+   mutable std::once_flag compiled_once;
+   mutable abi_program    compiled;
+
    template <typename T>
    abi_type(std::string name, T&& arg, const abi_serializer* ser)
        : name(std::move(name)), _data(std::forward<T>(arg)), ser(ser) {}
@@ -232,16 +331,120 @@ struct abi_type {
          return nullptr;
    }
    const struct_* as_struct() const { return std::get_if<struct_>(&_data); }
+   bool           is_builtin() const { return std::holds_alternative<builtin>(_data); }
+
+   // The program converting values of this type, compiled on first use. The type and every type it uses must
+   // be resolved.
+   const abi_program& program() const;
    const variant* as_variant() const { return std::get_if<variant>(&_data); }
 
+   // Advances bin past a value of this type without converting it. Fixed-size values and arrays of them are
+   // stepped over by their size; nothing is allocated. The type and every type it uses must be resolved.
+   void skip(input_stream& bin) const;
+
    std::string bin_to_json(
          input_stream& bin, std::function<void()> f = [] {}) const;
+   // Convert binary to MessagePack or CBOR, with the structure of the json from bin_to_json
+   std::vector<char> bin_to_msgpack(
+         input_stream& bin, std::function<void()> f = [] {}) const;
+   std::vector<char> bin_to_cbor(
+         input_stream& bin, std::function<void()> f = [] {}) const;
    std::vector<char> json_to_bin(
          std::string_view json, std::function<void()> f = [] {}) const;
    std::vector<char> json_to_bin_reorderable(
          std::string_view json, std::function<void()> f = [] {}) const;
 };
 
+// Selects field paths of a type for bin_to_json, which skips the binary of everything else. A path names a field
+// of the type, then a field of that field's value, and so on, separated by '.'. "[]" after an array's name continues
+// into each of its elements; optionals, extensions and variants are passed through. "action_traces[].act.name"
+// thus selects the name of each action of a transaction_trace_v0. The json has the shape of the full conversion,
+// with only the selected fields in each object; a variant alternative which has none of the paths is null.
+struct abi_projection {
+   struct node {
+      const abi_type* type = nullptr;
+      // Whether the value is converted in full
+      bool            whole = false;
+      // struct: the positions of the selected fields with their nodes, in order of position
+      std::vector<std::pair<uint32_t, uint32_t>> fields{};
+      // optional, extension, array: the node of the value within
+      uint32_t        inner = 0;
+      // variant: the node of each alternative, or 0 when it has none of the paths
+      std::vector<uint32_t> alternatives{};
+   };
+
+   // nodes[0] is the type's. Nodes refer to the type's abi, which must outlive the projection.
+   std::vector<node> nodes;
+
+   // The type and every type it uses must be resolved
+   abi_projection(const abi_type* type, const std::vector<std::string>& paths);
+
+   std::string bin_to_json(
+         input_stream& bin, std::function<void()> f = [] {}) const;
+};
+
+// Decodes rows of one type into columns, one for each builtin the type holds, named by its path, such as
+// "quantity" or "authorization[].actor". Fixed-size builtins are stored one after another in their binary form,
+// so a column of uint64 is an array of uint64_t. varuint32 and varint32 are stored as 4-byte integers. Strings,
+// bytes and other variable-size builtins are stored one after another, with offsets marking where each starts.
+// Each array has a list column whose offsets mark where each row's elements start in the columns of the
+// elements, which are listed after it. Variants and recursive structs are stored as variable-size values holding
+// their binary. Values within absent optionals and omitted extensions are null: zero bytes, or empty, and 0 in
+// validity.
+struct abi_columns {
+   static constexpr uint32_t npos = 0xffff'ffff;
+
+   struct column {
+      enum kind_t : uint8_t {
+         fixed,    // width bytes per value in data
+         variable, // values in data, from offsets[i] to offsets[i + 1]
+         list,     // lists of the values of the columns whose parent this is, from offsets[i] to offsets[i + 1]
+      };
+
+      std::string           name;
+      kind_t                kind   = fixed;
+      const abi_type*       type   = nullptr;
+      uint32_t              width  = 0;
+      // The list column this column's values are the elements of, or npos for one value per row
+      uint32_t              parent = npos;
+      // Whether values may be null, which validity then records
+      bool                  nullable = false;
+      std::vector<char>     data{};
+      // variable, list: 0, then the end of each value
+      std::vector<uint64_t> offsets{};
+      std::vector<uint8_t>  validity{};
+
+      // The number of values
+      uint64_t size() const { return kind == fixed ? data.size() / width : offsets.size() - 1; }
+   };
+
+   // How to decode a value into the columns
+   struct node {
+      enum code_t : uint8_t { fixed, varuint32, varint32, string, bytes, binary, optional, extension, object, list };
+
+      code_t                code   = fixed;
+      const abi_type*       type   = nullptr;
+      // The column of fixed, varuint32, varint32, string, bytes, binary and list nodes
+      uint32_t              column = 0;
+      // object: the nodes of the fields. optional, extension, list: the node of the value within.
+      std::vector<uint32_t> children{};
+   };
+
+   std::vector<column> columns;
+   // nodes[0] is the type's
+   std::vector<node>   nodes;
+   uint64_t            rows = 0;
+
+   // The type and every type it uses must be resolved, and outlive this
+   explicit abi_columns(const abi_type* type);
+
+   // Decodes a row. If it fails, the columns are left as they were.
+   void append(input_stream& bin);
+
+   // Removes the rows
+   void clear();
+};
+
 struct abi {
    std::map<eosio::name, std::string> action_types;
    std::map<eosio::name, std::string> table_types;
@@ -249,6 +452,23 @@ struct abi {
    std::map<eosio::name, std::string> action_result_types;
    const abi_type*                    get_type(const std::string& name);
 
+   // Set by convert_lazy. Types which are not resolved yet point into it.
+   std::shared_ptr<const abi_def> lazy_def;
+
+   // Returns the type if it is already present in abi_types (and, for lazily converted abis, resolved),
+   // otherwise nullptr. Never modifies this abi, so it may run concurrently with the get_type overload below.
+   const abi_type*                    find_type(const std::string& name) const;
+
+   // Like get_type, but never adds to abi_types and never modifies resolved types. Optional, array and
+   // extension types which are not already in abi_types are created in `derived`. The types created in
+   // `derived` or resolved are appended to `added`, with their programs compiled. Calls to this and to
+   // validate must be serialized by the caller.
+   const abi_type* get_type(const std::string& name, std::map<std::string, abi_type>& derived,
+                            std::vector<const abi_type*>& added);
+
+   // Resolves every type of a lazily converted abi, reporting the first error. Does nothing for other abis.
+   void validate(std::map<std::string, abi_type>& derived);
+
    // Adds a type to the abi.  Has no effect if the type is already present.
    // If the type is a struct, all members will be added recursively.
    // Exception Safety: basic. If add_type fails, some objects may have
@@ -260,6 +480,11 @@ struct abi {
 void convert(const abi_def& def, abi&);
 void convert(const abi& def, abi_def&);
 
+// Like convert(const abi_def&, abi&), but only registers the definitions. Each type is resolved, along with
+// the types it depends on, when it is first requested, so errors in types which are never used are only
+// reported by abi::validate.
+void convert_lazy(std::shared_ptr<const abi_def> def, abi&);
+
 extern const abi_serializer* const object_abi_serializer;
 extern const abi_serializer* const variant_abi_serializer;
 extern const abi_serializer* const array_abi_serializer;
@@ -293,6 +518,7 @@ auto add_type(abi& a, T*) -> std::enable_if_t<reflection::has_for_each_field_v<T
       auto member_type = a.add_type<std::decay_t<decltype(member((T*)nullptr))>>();
       s.fields.push_back({ name, member_type });
    });
+   s.index_fields();
    return &iter->second;
 }
 
@@ -323,6 +549,7 @@ auto add_type(abi& a, std::variant<T...>*) -> std::enable_if_t<!is_basic_abi_typ
             types.push_back({ type->name, type });
          }((T*)nullptr),
          ...);
+   types.index_alternatives();
    std::string name = get_type_name((std::variant<T...>*)nullptr);
 
    auto [iter, inserted] = a.abi_types.try_emplace(name, name, std::move(types), variant_abi_serializer);
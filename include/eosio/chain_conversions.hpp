@@ -213,33 +213,38 @@ constexpr inline uint64_t string_to_name_strict(std::string_view str) {
    __builtin_unreachable();
 }
 
-inline std::string name_to_string(uint64_t name) {
+// The *_to_chars functions write to dest, which must hold max_*_chars chars, and return the end of what they wrote
+constexpr std::size_t max_name_chars = 13;
+
+inline char* name_to_chars(uint64_t name, char* dest) {
    static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
-   std::string        str(13, '.');
 
    uint64_t tmp = name;
    for (uint32_t i = 0; i <= 12; ++i) {
-      char c      = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
-      str[12 - i] = c;
+      char c       = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+      dest[12 - i] = c;
       tmp >>= (i == 0 ? 4 : 5);
    }
 
-   const auto last = str.find_last_not_of('.');
-   return str.substr(0, last + 1);
+   char* end = dest + 13;
+   while (end != dest && end[-1] == '.') --end;
+   return end;
 }
 
-inline std::string microseconds_to_str(uint64_t microseconds) {
-   std::string result;
+inline std::string name_to_string(uint64_t name) {
+   char buf[max_name_chars];
+   return std::string(buf, name_to_chars(name, buf));
+}
 
-   auto append_uint = [&result](uint32_t value, int digits) {
-      char  s[20];
-      char* ch = s;
-      while (digits--) {
-         *ch++ = '0' + (value % 10);
+constexpr std::size_t max_microseconds_chars = 23;
+
+inline char* microseconds_to_chars(uint64_t microseconds, char* dest) {
+   auto append_uint = [&dest](uint32_t value, int digits) {
+      for (char* ch = dest + digits; ch != dest;) {
+         *--ch = '0' + (value % 10);
          value /= 10;
-      };
-      std::reverse(s, ch);
-      result.insert(result.end(), s, ch);
+      }
+      dest += digits;
    };
 
    std::chrono::microseconds us{ microseconds };
@@ -248,19 +253,24 @@ inline std::string microseconds_to_str(uint64_t microseconds) {
    uint32_t                  ms  = (std::chrono::floor<std::chrono::milliseconds>(us) - sd.time_since_epoch()).count();
    us -= sd.time_since_epoch();
    append_uint((int)ymd.year(), 4);
-   result.push_back('-');
+   *dest++ = '-';
    append_uint((unsigned)ymd.month(), 2);
-   result.push_back('-');
+   *dest++ = '-';
    append_uint((unsigned)ymd.day(), 2);
-   result.push_back('T');
+   *dest++ = 'T';
    append_uint(ms / 3600000 % 60, 2);
-   result.push_back(':');
+   *dest++ = ':';
    append_uint(ms / 60000 % 60, 2);
-   result.push_back(':');
+   *dest++ = ':';
    append_uint(ms / 1000 % 60, 2);
-   result.push_back('.');
+   *dest++ = '.';
    append_uint(ms % 1000, 3);
-   return result;
+   return dest;
+}
+
+inline std::string microseconds_to_str(uint64_t microseconds) {
+   char buf[max_microseconds_chars];
+   return std::string(buf, microseconds_to_chars(microseconds, buf));
 }
 
 [[nodiscard]] inline bool string_to_utc_seconds(uint32_t& result, const char*& s, const char* end, bool eat_fractional,
@@ -349,13 +359,19 @@ inline std::string microseconds_to_str(uint64_t microseconds) {
    return string_to_symbol_code(result, pos, end, true);
 }
 
-inline std::string symbol_code_to_string(uint64_t v) {
-   std::string result;
+constexpr std::size_t max_symbol_code_chars = 8;
+
+inline char* symbol_code_to_chars(uint64_t v, char* dest) {
    while (v > 0) {
-      result += char(v & 0xFF);
+      *dest++ = char(v & 0xFF);
       v >>= 8;
    }
-   return result;
+   return dest;
+}
+
+inline std::string symbol_code_to_string(uint64_t v) {
+   char buf[max_symbol_code_chars];
+   return std::string(buf, symbol_code_to_chars(v, buf));
 }
 
 [[nodiscard]] inline bool string_to_symbol(uint64_t& result, uint8_t precision, const char*& pos, const char* end,
@@ -383,8 +399,23 @@ inline std::string symbol_code_to_string(uint64_t v) {
    return string_to_symbol(result, pos, end, true);
 }
 
+// The precision, a comma and the code
+constexpr std::size_t max_symbol_chars = 3 + 1 + max_symbol_code_chars;
+
+inline char* symbol_to_chars(uint64_t v, char* dest) {
+   uint8_t precision = v;
+   if (precision >= 100)
+      *dest++ = '0' + precision / 100;
+   if (precision >= 10)
+      *dest++ = '0' + precision / 10 % 10;
+   *dest++ = '0' + precision % 10;
+   *dest++ = ',';
+   return symbol_code_to_chars(v >> 8, dest);
+}
+
 inline std::string symbol_to_string(uint64_t v) {
-   return std::to_string(v & 0xff) + "," + eosio::symbol_code_to_string(v >> 8);
+   char buf[max_symbol_chars];
+   return std::string(buf, symbol_to_chars(v, buf));
 }
 
 [[nodiscard]] inline bool string_to_asset(int64_t& amount, uint64_t& symbol, const char*& s, const char* end,
@@ -422,29 +453,38 @@ inline std::string symbol_to_string(uint64_t v) {
    return string_to_asset(amount, symbol, s, end, true);
 }
 
-inline std::string asset_to_string(int64_t amount, uint64_t symbol) {
-   std::string result;
-   uint64_t    uamount;
+// A sign, up to 255 fraction digits after a point, up to 20 integer digits, a space and the code
+constexpr std::size_t max_asset_chars = 1 + 255 + 1 + 20 + 1 + max_symbol_code_chars;
+
+inline char* asset_to_chars(int64_t amount, uint64_t symbol, char* dest) {
+   uint64_t uamount;
    if (amount < 0)
       uamount = -amount;
    else
       uamount = amount;
+   char*   begin     = dest;
    uint8_t precision = symbol;
    if (precision) {
       while (precision--) {
-         result += '0' + uamount % 10;
+         *dest++ = '0' + uamount % 10;
          uamount /= 10;
       }
-      result += '.';
+      *dest++ = '.';
    }
    do {
-      result += '0' + uamount % 10;
+      *dest++ = '0' + uamount % 10;
       uamount /= 10;
    } while (uamount);
    if (amount < 0)
-      result += '-';
-   std::reverse(result.begin(), result.end());
-   return result + ' ' + eosio::symbol_code_to_string(symbol >> 8);
+      *dest++ = '-';
+   std::reverse(begin, dest);
+   *dest++ = ' ';
+   return symbol_code_to_chars(symbol >> 8, dest);
+}
+
+inline std::string asset_to_string(int64_t amount, uint64_t symbol) {
+   char buf[max_asset_chars];
+   return std::string(buf, asset_to_chars(amount, symbol, buf));
 }
 
 } // namespace eosio
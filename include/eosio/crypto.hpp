@@ -116,6 +116,16 @@ private_key private_key_from_string(std::string_view s);
 std::string signature_to_string(const signature& obj);
 signature   signature_from_string(std::string_view s);
 
+// Conversions between the binary form of a key or signature and its string form which don't build the variant.
+// The *_bin_to_string functions write the string for the binary value in bin to dest and return its size, or 0 if
+// it needs more than size chars. The *_string_to_bin functions append the binary value to dest.
+std::size_t public_key_bin_to_string(std::string_view bin, char* dest, std::size_t size);
+void        public_key_string_to_bin(std::string_view s, std::vector<char>& dest);
+std::size_t private_key_bin_to_string(std::string_view bin, char* dest, std::size_t size);
+void        private_key_string_to_bin(std::string_view s, std::vector<char>& dest);
+std::size_t signature_bin_to_string(std::string_view bin, char* dest, std::size_t size);
+void        signature_string_to_bin(std::string_view s, std::vector<char>& dest);
+
 template <typename S>
 void to_json(const public_key& obj, S& stream) {
    to_json(public_key_to_string(obj), stream);
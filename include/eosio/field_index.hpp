@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace eosio {
+
+// Open-addressed hash table from names to their positions in a list: the fields of a struct or the
+// alternatives of a variant. The list itself is kept by the owner and passed in as name_of(i), so the table
+// only holds positions. Names which appear more than once are found in list order.
+struct field_index {
+   static constexpr uint32_t npos = 0xffff'ffff;
+
+   // position + 1, or 0 for an empty slot. The size is 0 or a power of two at least twice the list's.
+   std::vector<uint32_t> slots;
+   uint32_t              shift = 0;
+
+   // Mixes the length and the first and last 8 bytes, which between them tell apart almost all field
+   // and type names without reading the rest of the name
+   static uint64_t hash(std::string_view name) {
+      uint64_t head = 0, tail = 0;
+      size_t   n    = name.size() < 8 ? name.size() : 8;
+      if (n) {
+         memcpy(&head, name.data(), n);
+         memcpy(&tail, name.data() + name.size() - n, n);
+      }
+      return (head * 0x9e37'79b9'7f4a'7c15ull ^ (tail + name.size())) * 0xff51'afd7'ed55'8ccdull;
+   }
+
+   bool empty() const { return slots.empty(); }
+
+   template <typename F>
+   void build(uint32_t size, F&& name_of) {
+      slots.clear();
+      if (!size)
+         return;
+      uint32_t bits = 1;
+      while ((1u << bits) < size * 2)
+         ++bits;
+      shift = 64 - bits;
+      slots.assign(size_t(1) << bits, 0);
+      uint32_t mask = slots.size() - 1;
+      for (uint32_t i = 0; i < size; ++i) {
+         uint32_t s = hash(name_of(i)) >> shift;
+         while (slots[s])
+            s = (s + 1) & mask;
+         slots[s] = i + 1;
+      }
+   }
+
+   // Calls f with the position of each entry named name
+   template <typename N, typename F>
+   void for_each(std::string_view name, N&& name_of, F&& f) const {
+      if (slots.empty())
+         return;
+      uint32_t mask = slots.size() - 1;
+      for (uint32_t s = hash(name) >> shift; slots[s]; s = (s + 1) & mask)
+         if (name_of(slots[s] - 1) == name)
+            f(slots[s] - 1);
+   }
+
+   // Returns the position of the first entry named name, or npos
+   template <typename N>
+   uint32_t find(std::string_view name, N&& name_of) const {
+      if (slots.empty())
+         return npos;
+      uint32_t mask = slots.size() - 1;
+      for (uint32_t s = hash(name) >> shift; slots[s]; s = (s + 1) & mask)
+         if (name_of(slots[s] - 1) == name)
+            return slots[s] - 1;
+      return npos;
+   }
+};
+
+} // namespace eosio
@@ -233,11 +233,17 @@ void to_key(const fixed_bytes<Size, T>& obj, S& stream) {
 
 template <typename T, std::size_t Size, typename S>
 void from_json(fixed_bytes<Size, T>& obj, S& stream) {
-   std::vector<char> v;
-   eosio::from_json_hex(v, stream);
-   check(v.size() == Size, convert_json_error(eosio::from_json_error::hex_string_incorrect_length));
+   auto s = stream.get_string();
+   if (s.size() != 2 * Size) {
+      // Strings of anything but hex digits get the error they would for other hex types
+      std::vector<char> v(s.size() / 2);
+      check(!(s.size() & 1) && hex_decode(s.data(), s.size(), v.data()),
+            convert_json_error(eosio::from_json_error::expected_hex_string));
+      check(false, convert_json_error(eosio::from_json_error::hex_string_incorrect_length));
+   }
    std::array<uint8_t, Size> bytes;
-   std::memcpy(bytes.data(), v.data(), Size);
+   check(hex_decode(s.data(), s.size(), reinterpret_cast<char*>(bytes.data())),
+         convert_json_error(eosio::from_json_error::expected_hex_string));
    obj = fixed_bytes<Size, T>(bytes);
 }
 
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <cstdlib>
+#include "field_index.hpp"
 #include "for_each_field.hpp"
+#include "hex.hpp"
+#include "json_structural.hpp"
 #include "check.hpp"
 #include <functional>
 #include <optional>
@@ -178,22 +181,50 @@ struct json_token {
    std::string_view value_string = {};
 };
 
+// How json_token_stream splits json into tokens. Both give the same tokens and errors.
+enum class json_tokenizer {
+   rapidjson,  // rapidjson's iterative parser, one token at a time
+   structural, // json_structural_reader, which indexes the whole input with SIMD first
+};
+
+#ifdef ABIEOS_STRUCTURAL_JSON
+inline constexpr json_tokenizer default_json_tokenizer = json_tokenizer::structural;
+#else
+inline constexpr json_tokenizer default_json_tokenizer = json_tokenizer::rapidjson;
+#endif
+
 class json_token_stream : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, json_token_stream> {
  private:
    rapidjson::Reader             reader;
    rapidjson::InsituStringStream ss;
+   json_structural_reader        structural;
+   bool                          use_structural = false;
 
  public:
    json_token current_token;
 
    // This modifies json
-   json_token_stream(char* json) : ss{ json } { reader.IterativeParseInit(); }
+   json_token_stream(char* json, json_tokenizer tokenizer = default_json_tokenizer) : ss{ json } {
+      if (tokenizer == json_tokenizer::structural) {
+         size_t size    = strlen(json);
+         use_structural = size < json_structural_reader::end;
+         if (use_structural) {
+            structural.init(json, size);
+            return;
+         }
+      }
+      reader.IterativeParseInit();
+   }
 
-   bool complete() { return reader.IterativeParseComplete(); }
+   bool complete() { return use_structural ? structural.complete() : reader.IterativeParseComplete(); }
 
    std::reference_wrapper<const json_token> peek_token() {
       if (current_token.type != json_token_type::type_unread)
          return current_token;
+      if (use_structural) {
+         check( structural.parse_next(*this), convert_error_to_string_view(structural.get_error()) );
+         return current_token;
+      }
       check( reader.IterativeParseNext<rapidjson::kParseInsituFlag | rapidjson::kParseValidateEncodingFlag |
                                          rapidjson::kParseIterativeFlag | rapidjson::kParseNumbersAsStringsFlag>(ss, *this),
             convert_error_to_string_view(reader.GetParseErrorCode()) );
@@ -606,9 +637,8 @@ template <typename S>
 void from_json_hex(std::vector<char>& result, S& stream) {
    auto s = stream.get_string();
    check( !(s.size() & 1), convert_json_error(from_json_error::expected_hex_string) );
-   result.clear();
-   result.reserve(s.size() / 2);
-   check( unhex(std::back_inserter(result), s.begin(), s.end()),
+   result.resize(s.size() / 2);
+   check( hex_decode(s.data(), s.size(), result.data()),
          convert_json_error(from_json_error::expected_hex_string) );
 }
 
@@ -617,7 +647,7 @@ void from_json_hex(std::vector<char>& result, S& stream) {
 template <typename S> void from_json(long double& result, S& stream) {
    auto s = stream.get_string();
    check( s.size() == 32, convert_json_error(from_json_error::expected_hex_string) );
-   check( unhex(reinterpret_cast<char*>(&result), s.begin(), s.end()),
+   check( hex_decode(s.data(), s.size(), reinterpret_cast<char*>(&result)),
           convert_json_error(from_json_error::expected_hex_string) );
 }
 
@@ -651,21 +681,58 @@ void from_json_skip_value(S& stream) {
    } while (depth);
 }
 
+/// \exclude
+/// The member names of a reflected type, indexed once per type
+template <typename T>
+struct reflected_fields {
+   std::vector<std::string_view> names;
+   field_index                   index;
+
+   static const reflected_fields& get() {
+      static const reflected_fields fields = [] {
+         reflected_fields result;
+         eosio::for_each_field<T>([&](std::string_view name, auto) { result.names.push_back(name); });
+         result.index.build(result.names.size(), [&](uint32_t i) { return result.names[i]; });
+         return result;
+      }();
+      return fields;
+   }
+
+   uint32_t find(std::string_view name) const {
+      return index.find(name, [&](uint32_t i) { return names[i]; });
+   }
+};
+
+/// \exclude
+/// Parsers of the members of a reflected type from S, in the order of reflected_fields<T>::names
+template <typename T, typename S>
+struct reflected_member_parsers {
+   std::vector<std::function<void(T&, S&)>> parsers;
+
+   static const reflected_member_parsers& get() {
+      static const reflected_member_parsers members = [] {
+         reflected_member_parsers result;
+         eosio::for_each_field<T>([&](std::string_view, auto member) {
+            result.parsers.push_back([member](T& obj, S& stream) { from_json(member(&obj), stream); });
+         });
+         return result;
+      }();
+      return members;
+   }
+};
+
 /// \output_section Parse JSON (Reflected Objects)
 /// Parse JSON and convert to `obj`. This overload works with
 /// [reflected objects](standardese://reflection/).
 template <typename T, typename S>
 void from_json(T& obj, S& stream) {
+   auto& fields  = reflected_fields<T>::get();
+   auto& members = reflected_member_parsers<T, S>::get();
    from_json_object(stream, [&](std::string_view key) {
-      bool found = false;
-      eosio::for_each_field<T>([&](std::string_view member_name, auto member) {
-         if (!found && key == member_name) {
-            from_json(member(&obj), stream);
-            found = true;
-         }
-      });
-      if (!found)
-         from_json_skip_value(stream);
+      uint32_t found = fields.find(key);
+      if (found == field_index::npos)
+         return from_json_skip_value(stream);
+      members.parsers[found](obj, stream);
    });
 }
 
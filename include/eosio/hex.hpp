@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#   include <immintrin.h>
+#   define EOSIO_HEX_X86
+#endif
+
+namespace eosio {
+
+// Hex conversion of whole buffers, 16 bytes at a time with SSE2. Digits are written in upper case; both cases are
+// read.
+
+inline char hex_digit(uint8_t nibble) { return nibble < 10 ? '0' + nibble : 'A' + nibble - 10; }
+
+// Writes the 2 * size hex digits of data to dest
+inline void hex_encode(const char* data, std::size_t size, char* dest) {
+   std::size_t i = 0;
+#ifdef EOSIO_HEX_X86
+   auto digits = [](__m128i n) {
+      __m128i letter = _mm_cmpgt_epi8(n, _mm_set1_epi8(9));
+      return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), _mm_and_si128(letter, _mm_set1_epi8('A' - '0' - 10)));
+   };
+   for (; size - i >= 16; i += 16) {
+      __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      __m128i hi = digits(_mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f)));
+      __m128i lo = digits(_mm_and_si128(v, _mm_set1_epi8(0x0f)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2 * i), _mm_unpacklo_epi8(hi, lo));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+   }
+#endif
+   for (; i < size; ++i) {
+      uint8_t byte    = data[i];
+      dest[2 * i]     = hex_digit(byte >> 4);
+      dest[2 * i + 1] = hex_digit(byte & 15);
+   }
+}
+
+// Writes the size / 2 bytes of the hex digits in src, of which there must be an even number, to dest. Returns false
+// if src has anything else, leaving dest partly written.
+[[nodiscard]] inline bool hex_decode(const char* src, std::size_t size, char* dest) {
+   std::size_t i = 0;
+#ifdef EOSIO_HEX_X86
+   // The values of 16 digits, with all bits of invalid set when any of them isn't one
+   auto nibbles = [](__m128i c, __m128i& invalid) {
+      __m128i digit     = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+      __m128i is_digit  = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+      __m128i letter    = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+      __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+      invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(is_digit, is_letter), _mm_set1_epi8(-1)));
+      return _mm_or_si128(_mm_and_si128(is_digit, digit),
+                          _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+   };
+   // Each 16-bit lane holds a high digit then a low digit
+   auto bytes = [](__m128i n) {
+      return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(n, _mm_set1_epi16(0xff)), 4), _mm_srli_epi16(n, 8));
+   };
+   for (; size - i >= 32; i += 32) {
+      __m128i invalid = _mm_setzero_si128();
+      __m128i a       = nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), invalid);
+      __m128i b       = nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16)), invalid);
+      if (_mm_movemask_epi8(invalid))
+         return false;
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i / 2), _mm_packus_epi16(bytes(a), bytes(b)));
+   }
+#endif
+   auto nibble = [](char c, uint8_t& value) {
+      if (c >= '0' && c <= '9')
+         value = c - '0';
+      else if (c >= 'a' && c <= 'f')
+         value = c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+         value = c - 'A' + 10;
+      else
+         return false;
+      return true;
+   };
+   for (; i + 1 < size; i += 2) {
+      uint8_t h, l;
+      if (!nibble(src[i], h) || !nibble(src[i + 1], l))
+         return false;
+      dest[i / 2] = (h << 4) | l;
+   }
+   return i == size;
+}
+
+} // namespace eosio
@@ -0,0 +1,559 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <rapidjson/reader.h>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#   include <immintrin.h>
+#   define EOSIO_JSON_STRUCTURAL_X86
+#endif
+
+namespace eosio {
+
+// The bytes of one 64-byte block which json_structural_index looks at, 1 bit per byte
+struct json_block_masks {
+   uint64_t quote      = 0;
+   uint64_t backslash  = 0;
+   uint64_t whitespace = 0;
+   uint64_t op         = 0; // {}[]:,
+   uint64_t special    = 0; // backslashes, control characters and non-ascii bytes
+};
+
+inline json_block_masks json_classify_scalar(const uint8_t* p) {
+   json_block_masks m;
+   for (int i = 0; i < 64; ++i) {
+      uint64_t bit = uint64_t(1) << i;
+      uint8_t  c   = p[i];
+      switch (c) {
+         case '"': m.quote |= bit; break;
+         case '\\': m.backslash |= bit; break;
+         case ' ':
+         case '\t':
+         case '\n':
+         case '\r': m.whitespace |= bit; break;
+         case '{':
+         case '}':
+         case '[':
+         case ']':
+         case ':':
+         case ',': m.op |= bit; break;
+      }
+      if (c < 0x20 || c >= 0x80 || c == '\\')
+         m.special |= bit;
+   }
+   return m;
+}
+
+#ifdef EOSIO_JSON_STRUCTURAL_X86
+inline json_block_masks json_classify_sse2(const uint8_t* p) {
+   json_block_masks m;
+   for (int i = 0; i < 4; ++i) {
+      __m128i v   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+      __m128i v20 = _mm_or_si128(v, _mm_set1_epi8(0x20));
+      auto    bits = [&](__m128i x) { return uint64_t(uint16_t(_mm_movemask_epi8(x))) << (16 * i); };
+      auto    eq   = [&](__m128i x, char c) { return _mm_cmpeq_epi8(x, _mm_set1_epi8(c)); };
+      uint64_t backslash = bits(eq(v, '\\'));
+      m.quote |= bits(eq(v, '"'));
+      m.backslash |= backslash;
+      m.whitespace |= bits(_mm_or_si128(_mm_or_si128(eq(v, ' '), eq(v, '\t')), _mm_or_si128(eq(v, '\n'), eq(v, '\r'))));
+      // '[' and ']' differ from '{' and '}' only in bit 0x20
+      m.op |= bits(_mm_or_si128(_mm_or_si128(eq(v20, '{'), eq(v20, '}')), _mm_or_si128(eq(v, ':'), eq(v, ','))));
+      // signed: bytes from 0x80 up are negative
+      m.special |= backslash | bits(_mm_cmplt_epi8(v, _mm_set1_epi8(0x20)));
+   }
+   return m;
+}
+
+// Lambdas would not inherit the target attribute, so this one is spelled out
+__attribute__((target("avx2"))) inline json_block_masks json_classify_avx2(const uint8_t* p) {
+   json_block_masks m;
+   for (int i = 0; i < 2; ++i) {
+      __m256i  v   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+      __m256i  v20 = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+      __m256i  ws  = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+      __m256i  op  = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v20, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(v20, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+      __m256i  low = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v);
+      int      shift     = 32 * i;
+      uint64_t backslash = uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))))) << shift;
+      m.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))))) << shift;
+      m.backslash |= backslash;
+      m.whitespace |= uint64_t(uint32_t(_mm256_movemask_epi8(ws))) << shift;
+      m.op |= uint64_t(uint32_t(_mm256_movemask_epi8(op))) << shift;
+      m.special |= backslash | uint64_t(uint32_t(_mm256_movemask_epi8(low))) << shift;
+   }
+   return m;
+}
+#endif
+
+// Bit i of the result is the xor of bits 0 through i of x
+inline uint64_t json_prefix_xor(uint64_t x) {
+   x ^= x << 1;
+   x ^= x << 2;
+   x ^= x << 4;
+   x ^= x << 8;
+   x ^= x << 16;
+   x ^= x << 32;
+   return x;
+}
+
+// The first stage of json_structural_reader. One pass over the whole input, 64 bytes at a time, finds the
+// structural characters ({}[]:,), the opening quote of each string and the first byte of each other scalar.
+// Strings are told apart by a prefix xor over the unescaped quotes, so nothing inside them is indexed. The
+// quotes, and the bytes inside strings which need a closer look, are kept as bitmaps for the second stage.
+struct json_structural_index {
+   std::vector<uint32_t> positions;
+   uint32_t              count = 0;
+   std::vector<uint64_t> quotes;   // unescaped quotes
+   std::vector<uint64_t> specials; // see json_block_masks
+
+   // json must be shorter than 4GB
+   void build(const char* json, size_t size) {
+#ifdef EOSIO_JSON_STRUCTURAL_X86
+      static const bool avx2 = __builtin_cpu_supports("avx2");
+      if (avx2)
+         return build_with<json_classify_avx2>(json, size);
+      return build_with<json_classify_sse2>(json, size);
+#else
+      return build_with<json_classify_scalar>(json, size);
+#endif
+   }
+
+   template <json_block_masks (*classify)(const uint8_t*)>
+   void build_with(const char* json, size_t size) {
+      size_t blocks = (size + 63) / 64;
+      count         = 0;
+      positions.resize(std::max<size_t>(64, size / 4));
+      quotes.resize(blocks);
+      specials.resize(blocks);
+
+      uint64_t prev_escaped = 0, prev_in_string = 0, prev_scalar = 0;
+      for (size_t b = 0; b < blocks; ++b) {
+         auto*   p = reinterpret_cast<const uint8_t*>(json) + b * 64;
+         uint8_t tail[64];
+         if (size - b * 64 < 64) {
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, p, size - b * 64);
+            p = tail;
+         }
+         auto m = classify(p);
+
+         // A backslash escapes the next byte unless it is escaped itself. Runs of backslashes are rare enough
+         // to walk one at a time.
+         uint64_t escaped = prev_escaped;
+         prev_escaped     = 0;
+         for (uint64_t bs = m.backslash; bs; bs &= bs - 1) {
+            int i = __builtin_ctzll(bs);
+            if ((escaped >> i) & 1)
+               continue;
+            if (i == 63)
+               prev_escaped = 1;
+            else
+               escaped |= uint64_t(2) << i;
+         }
+
+         uint64_t quote     = m.quote & ~escaped;
+         uint64_t in_string = json_prefix_xor(quote) ^ prev_in_string; // opening quotes and what follows them
+         prev_in_string     = uint64_t(int64_t(in_string) >> 63);
+         uint64_t strings   = in_string | quote;
+         uint64_t scalar    = ~(m.whitespace | m.op | strings);
+         uint64_t structural =
+               (m.op & ~strings) | (quote & in_string) | (scalar & ~((scalar << 1) | prev_scalar));
+         prev_scalar = scalar >> 63;
+         quotes[b]   = quote;
+         specials[b] = m.special;
+
+         if (positions.size() < count + 64)
+            positions.resize(positions.size() * 2);
+         for (; structural; structural &= structural - 1)
+            positions[count++] = b * 64 + __builtin_ctzll(structural);
+      }
+   }
+
+   // Returns the first unescaped quote at or after pos, or size if there is none
+   size_t next_quote(size_t pos, size_t size) const {
+      for (size_t b = pos / 64; b < quotes.size(); ++b) {
+         uint64_t q = quotes[b];
+         if (b == pos / 64)
+            q &= ~uint64_t(0) << (pos % 64);
+         if (q)
+            return b * 64 + __builtin_ctzll(q);
+      }
+      return size;
+   }
+
+   // Whether any byte in [begin, end) is special
+   bool any_special(size_t begin, size_t end) const {
+      for (size_t b = begin / 64; b * 64 < end; ++b) {
+         uint64_t s = specials[b];
+         if (b == begin / 64)
+            s &= ~uint64_t(0) << (begin % 64);
+         if (end < b * 64 + 64)
+            s &= ~(~uint64_t(0) << (end % 64));
+         if (s)
+            return true;
+      }
+      return false;
+   }
+};
+
+// A replacement for rapidjson's iterative parser, as json_token_stream uses it (insitu, validating utf-8,
+// numbers as strings), over a json_structural_index. It follows the same grammar and reports the same
+// errors at the same tokens. json must be null terminated.
+class json_structural_reader {
+ public:
+   static constexpr uint32_t end = 0xffff'ffff;
+
+   json_structural_reader() = default;
+
+   void init(char* json, size_t size) {
+      this->json = json;
+      this->size = size;
+      index.build(json, size);
+      next     = 0;
+      resume   = end;
+      state    = start;
+      error    = rapidjson::kParseErrorNone;
+      returns.clear();
+   }
+
+   bool complete() const { return state == finished || state == failed; }
+   rapidjson::ParseErrorCode get_error() const { return error; }
+
+   // Calls one of handler's methods for the next token, like rapidjson::Reader::IterativeParseNext. Returns
+   // true without calling handler once the document is complete.
+   template <typename Handler>
+   bool parse_next(Handler& handler) {
+      while (!complete()) {
+         uint32_t pos = next_position();
+         if (pos == end) {
+            // rapidjson reads the terminator as the start of a value when there was only whitespace
+            if (state == start && size)
+               return fail(rapidjson::kParseErrorValueInvalid);
+            return fail_in_state();
+         }
+         char c = json[pos];
+         switch (state) {
+            case start: return is_value(c) ? value(pos, handler, finished) : fail_in_state();
+            case object_initial:
+               if (c == '"')
+                  return key(pos, handler);
+               return c == '}' ? end_container(handler, true) : fail_in_state();
+            case member_key:
+               if (c != ':')
+                  return fail_in_state();
+               state = key_value_delimiter;
+               continue;
+            case key_value_delimiter: return is_value(c) ? value(pos, handler, member_value) : fail_in_state();
+            case member_value:
+               if (c == ',') {
+                  state = member_delimiter;
+                  continue;
+               }
+               return c == '}' ? end_container(handler, true) : fail_in_state();
+            case member_delimiter: return c == '"' ? key(pos, handler) : fail_in_state();
+            case array_initial:
+               if (c == ']')
+                  return end_container(handler, false);
+               return is_value(c) ? value(pos, handler, element) : fail_in_state();
+            case element:
+               if (c == ',') {
+                  state = element_delimiter;
+                  continue;
+               }
+               return c == ']' ? end_container(handler, false) : fail_in_state();
+            case element_delimiter: return is_value(c) ? value(pos, handler, element) : fail_in_state();
+            default: return fail_in_state();
+         }
+      }
+      return state == finished;
+   }
+
+ private:
+   enum state_t : uint8_t {
+      start,
+      finished,
+      failed,
+      object_initial,
+      member_key,
+      key_value_delimiter,
+      member_value,
+      member_delimiter,
+      array_initial,
+      element,
+      element_delimiter,
+   };
+
+   char*                     json = nullptr;
+   size_t                    size = 0;
+   json_structural_index     index;
+   uint32_t                  next   = 0;
+   uint32_t                  resume = end; // where a scalar stopped short of the next indexed position
+   state_t                   state  = start;
+   rapidjson::ParseErrorCode error  = rapidjson::kParseErrorNone;
+   std::vector<state_t>      returns; // the state to return to after each open object or array
+
+   static bool is_value(char c) { return c != ',' && c != ':' && c != ']' && c != '}'; }
+   static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+   uint32_t next_position() {
+      if (resume != end)
+         return std::exchange(resume, end);
+      return next < index.count ? index.positions[next++] : end;
+   }
+
+   bool fail(rapidjson::ParseErrorCode code) {
+      error = code;
+      state = failed;
+      return false;
+   }
+
+   bool fail_in_state() {
+      switch (state) {
+         case start: return fail(rapidjson::kParseErrorDocumentEmpty);
+         case finished: return fail(rapidjson::kParseErrorDocumentRootNotSingular);
+         case object_initial:
+         case member_delimiter: return fail(rapidjson::kParseErrorObjectMissName);
+         case member_key: return fail(rapidjson::kParseErrorObjectMissColon);
+         case member_value: return fail(rapidjson::kParseErrorObjectMissCommaOrCurlyBracket);
+         case element: return fail(rapidjson::kParseErrorArrayMissCommaOrSquareBracket);
+         default: return fail(rapidjson::kParseErrorValueInvalid);
+      }
+   }
+
+   // Moves to state after a complete value; at the end of the document nothing but whitespace may follow
+   bool done(state_t after) {
+      state = after;
+      if (state == finished && next_position() != end)
+         return fail(rapidjson::kParseErrorDocumentRootNotSingular);
+      return true;
+   }
+
+   template <typename Handler>
+   bool end_container(Handler& handler, bool object) {
+      state_t after = returns.back();
+      returns.pop_back();
+      if (!(object ? handler.EndObject(0) : handler.EndArray(0)))
+         return fail(rapidjson::kParseErrorTermination);
+      return done(after);
+   }
+
+   template <typename Handler>
+   bool key(uint32_t pos, Handler& handler) {
+      char*    s;
+      uint32_t len;
+      if (!parse_string(pos, s, len))
+         return false;
+      state = member_key;
+      return handler.Key(s, len, false) || fail(rapidjson::kParseErrorTermination);
+   }
+
+   template <typename Handler>
+   bool value(uint32_t pos, Handler& handler, state_t after) {
+      char c = json[pos];
+      if (c == '{' || c == '[') {
+         returns.push_back(after);
+         state = c == '{' ? object_initial : array_initial;
+         if (!(c == '{' ? handler.StartObject() : handler.StartArray()))
+            return fail(rapidjson::kParseErrorTermination);
+         return true;
+      }
+      if (c == '"') {
+         char*    s;
+         uint32_t len;
+         if (!parse_string(pos, s, len))
+            return false;
+         if (!handler.String(s, len, false))
+            return fail(rapidjson::kParseErrorTermination);
+         return done(after);
+      }
+
+      const char* p = json + pos;
+      bool        ok;
+      if (c == 't' || c == 'f' || c == 'n') {
+         const char* literal = c == 't' ? "true" : c == 'f' ? "false" : "null";
+         for (; *literal; ++literal, ++p)
+            if (*p != *literal)
+               return fail(rapidjson::kParseErrorValueInvalid);
+         ok = c == 'n' ? handler.Null() : handler.Bool(c == 't');
+      } else {
+         if (*p == '-')
+            ++p;
+         if (*p == '0')
+            ++p;
+         else if (*p >= '1' && *p <= '9')
+            while (is_digit(*p))
+               ++p;
+         else
+            return fail(rapidjson::kParseErrorValueInvalid);
+         if (*p == '.') {
+            if (!is_digit(*++p))
+               return fail(rapidjson::kParseErrorNumberMissFraction);
+            while (is_digit(*p))
+               ++p;
+         }
+         if (*p == 'e' || *p == 'E') {
+            ++p;
+            if (*p == '+' || *p == '-')
+               ++p;
+            if (!is_digit(*p))
+               return fail(rapidjson::kParseErrorNumberMissExponent);
+            while (is_digit(*p))
+               ++p;
+         }
+         ok = handler.RawNumber(json + pos, uint32_t(p - (json + pos)), false);
+      }
+      if (!ok)
+         return fail(rapidjson::kParseErrorTermination);
+
+      // Whatever follows without a separator, as in 01 or truex, is read as the next token
+      switch (*p) {
+         case '\0':
+         case ' ':
+         case '\t':
+         case '\n':
+         case '\r':
+         case '"':
+         case '{':
+         case '}':
+         case '[':
+         case ']':
+         case ':':
+         case ',': break;
+         default: resume = p - json;
+      }
+      return done(after);
+   }
+
+   // Unescapes the string at the opening quote pos in place and null terminates it
+   bool parse_string(uint32_t pos, char*& s, uint32_t& len) {
+      size_t close = index.next_quote(pos + 1, size);
+      s            = json + pos + 1;
+      if (!index.any_special(pos + 1, close)) {
+         if (close == size)
+            return fail(rapidjson::kParseErrorStringMissQuotationMark);
+         len         = close - pos - 1;
+         json[close] = 0;
+         return true;
+      }
+
+      const char* p   = s;
+      char*       out = s;
+      while (true) {
+         auto c = uint8_t(*p);
+         if (c == '"')
+            break;
+         if (c < 0x20)
+            return fail(c ? rapidjson::kParseErrorStringInvalidEncoding
+                          : rapidjson::kParseErrorStringMissQuotationMark);
+         if (c == '\\') {
+            switch (p[1]) {
+               case '"': *out++ = '"'; break;
+               case '\\': *out++ = '\\'; break;
+               case '/': *out++ = '/'; break;
+               case 'b': *out++ = '\b'; break;
+               case 'f': *out++ = '\f'; break;
+               case 'n': *out++ = '\n'; break;
+               case 'r': *out++ = '\r'; break;
+               case 't': *out++ = '\t'; break;
+               case 'u': {
+                  uint32_t code;
+                  if (!parse_hex4(p + 2, code))
+                     return fail(rapidjson::kParseErrorStringUnicodeEscapeInvalidHex);
+                  p += 6;
+                  if (code >= 0xd800 && code <= 0xdfff) {
+                     uint32_t low;
+                     if (code > 0xdbff || p[0] != '\\' || p[1] != 'u')
+                        return fail(rapidjson::kParseErrorStringUnicodeSurrogateInvalid);
+                     if (!parse_hex4(p + 2, low))
+                        return fail(rapidjson::kParseErrorStringUnicodeEscapeInvalidHex);
+                     if (low < 0xdc00 || low > 0xdfff)
+                        return fail(rapidjson::kParseErrorStringUnicodeSurrogateInvalid);
+                     p += 6;
+                     code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                  }
+                  out = put_utf8(out, code);
+                  continue;
+               }
+               default: return fail(rapidjson::kParseErrorStringEscapeInvalid);
+            }
+            p += 2;
+            continue;
+         }
+         if (c >= 0x80) {
+            int n = utf8_length(reinterpret_cast<const uint8_t*>(p));
+            if (!n)
+               return fail(rapidjson::kParseErrorStringInvalidEncoding);
+            for (int i = 0; i < n; ++i)
+               *out++ = *p++;
+            continue;
+         }
+         *out++ = *p++;
+      }
+      len  = out - s;
+      *out = 0;
+      return true;
+   }
+
+   static bool parse_hex4(const char* p, uint32_t& code) {
+      code = 0;
+      for (int i = 0; i < 4; ++i) {
+         char c = p[i];
+         if (c >= '0' && c <= '9')
+            code = code * 16 + (c - '0');
+         else if (c >= 'a' && c <= 'f')
+            code = code * 16 + (c - 'a' + 10);
+         else if (c >= 'A' && c <= 'F')
+            code = code * 16 + (c - 'A' + 10);
+         else
+            return false;
+      }
+      return true;
+   }
+
+   static char* put_utf8(char* out, uint32_t code) {
+      if (code < 0x80) {
+         *out++ = char(code);
+      } else if (code < 0x800) {
+         *out++ = char(0xc0 | (code >> 6));
+         *out++ = char(0x80 | (code & 0x3f));
+      } else if (code < 0x10000) {
+         *out++ = char(0xe0 | (code >> 12));
+         *out++ = char(0x80 | ((code >> 6) & 0x3f));
+         *out++ = char(0x80 | (code & 0x3f));
+      } else {
+         *out++ = char(0xf0 | (code >> 18));
+         *out++ = char(0x80 | ((code >> 12) & 0x3f));
+         *out++ = char(0x80 | ((code >> 6) & 0x3f));
+         *out++ = char(0x80 | (code & 0x3f));
+      }
+      return out;
+   }
+
+   // The length of the well-formed utf-8 sequence at p, or 0. Overlong forms, surrogates and code points past
+   // U+10FFFF are rejected.
+   static int utf8_length(const uint8_t* p) {
+      auto cont = [](uint8_t c) { return (c & 0xc0) == 0x80; };
+      uint8_t c = p[0];
+      if (c >= 0xc2 && c <= 0xdf)
+         return cont(p[1]) ? 2 : 0;
+      if (c >= 0xe0 && c <= 0xef) {
+         uint8_t lo = c == 0xe0 ? 0xa0 : 0x80, hi = c == 0xed ? 0x9f : 0xbf;
+         return p[1] >= lo && p[1] <= hi && cont(p[2]) ? 3 : 0;
+      }
+      if (c >= 0xf0 && c <= 0xf4) {
+         uint8_t lo = c == 0xf0 ? 0x90 : 0x80, hi = c == 0xf4 ? 0x8f : 0xbf;
+         return p[1] >= lo && p[1] <= hi && cont(p[2]) && cont(p[3]) ? 4 : 0;
+      }
+      return 0;
+   }
+}; // json_structural_reader
+
+} // namespace eosio
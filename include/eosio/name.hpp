@@ -159,7 +159,8 @@ void from_json(name& obj, S& stream) {
 
 template <typename S>
 void to_json(const name& obj, S& stream) {
-   to_json(eosio::name_to_string(obj.value), stream);
+   char buf[max_name_chars];
+   to_json(std::string_view(buf, eosio::name_to_chars(obj.value, buf) - buf), stream);
 }
 
 inline namespace literals {
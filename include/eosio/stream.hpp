@@ -120,6 +120,40 @@ struct fixed_buf_stream {
    }
 };
 
+// Like fixed_buf_stream, but running out of space isn't an error. Output which doesn't fit is dropped while
+// `size` keeps counting, so after writing it holds the space the complete output needs.
+struct bounded_buf_stream {
+   char*  pos;
+   char*  end;
+   size_t size = 0;
+
+   bounded_buf_stream(char* pos, size_t size) : pos{ pos }, end{ pos + size } {}
+
+   void write(char c) {
+      if (pos < end)
+         *pos++ = c;
+      ++size;
+   }
+
+   void write(const void* src, std::size_t sz) {
+      auto n = std::min(sz, size_t(end - pos));
+      if (n)
+         memcpy(pos, src, n);
+      pos += n;
+      size += sz;
+   }
+
+   template <int Size>
+   void write(const char (&src)[Size]) {
+      write(src, Size);
+   }
+
+   template <typename T>
+   void write_raw(const T& v) {
+      write(&v, sizeof(v));
+   }
+};
+
 struct size_stream {
    size_t size = 0;
 
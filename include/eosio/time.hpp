@@ -99,7 +99,8 @@ void from_json(time_point& obj, S& stream) {
 
 template <typename S>
 void to_json(const time_point& obj, S& stream) {
-   return to_json(eosio::microseconds_to_str(obj.elapsed._count), stream);
+   char buf[max_microseconds_chars];
+   return to_json(std::string_view(buf, microseconds_to_chars(obj.elapsed._count, buf) - buf), stream);
 }
 
 /**
@@ -178,7 +179,9 @@ void from_json(time_point_sec& obj, S& stream) {
 
 template <typename S>
 void to_json(const time_point_sec& obj, S& stream) {
-   return to_json(eosio::microseconds_to_str(uint64_t(obj.utc_seconds) * 1'000'000), stream);
+   char buf[max_microseconds_chars];
+   return to_json(std::string_view(buf, microseconds_to_chars(uint64_t(obj.utc_seconds) * 1'000'000, buf) - buf),
+                  stream);
 }
 
 /**
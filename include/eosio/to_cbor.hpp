@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace eosio {
+
+// Writes CBOR (RFC 8949) values to data, each in its shortest form except the sizes of maps, which are sized for
+// the largest they can be: begin_map writes their header, and end_map fills in their size once it is known.
+struct cbor_writer {
+   std::vector<char>& data;
+
+   void write(uint8_t b) { data.push_back(char(b)); }
+
+   // Writes the low n bytes of v, big-endian
+   void write_be(uint64_t v, int n) {
+      for (int shift = (n - 1) * 8; shift >= 0; shift -= 8)
+         data.push_back(char(v >> shift));
+   }
+
+   // Writes the initial byte of major type major with argument v, followed by v if it doesn't fit in it
+   void head(uint8_t major, uint64_t v) {
+      major <<= 5;
+      if (v < 24)
+         write(major | v);
+      else if (v <= 0xff)
+         write(major | 24), write_be(v, 1);
+      else if (v <= 0xffff)
+         write(major | 25), write_be(v, 2);
+      else if (v <= 0xffff'ffff)
+         write(major | 26), write_be(v, 4);
+      else
+         write(major | 27), write_be(v, 8);
+   }
+
+   void nil() { write(0xf6); }
+   void boolean(bool v) { write(v ? 0xf5 : 0xf4); }
+   void uint(uint64_t v) { head(0, v); }
+   void sint(int64_t v) { v >= 0 ? head(0, v) : head(1, ~uint64_t(v)); }
+
+   void f32(float v) {
+      uint32_t bits;
+      memcpy(&bits, &v, sizeof(bits));
+      write(0xfa), write_be(bits, 4);
+   }
+
+   void f64(double v) {
+      uint64_t bits;
+      memcpy(&bits, &v, sizeof(bits));
+      write(0xfb), write_be(bits, 8);
+   }
+
+   void str(std::string_view s) {
+      head(3, s.size());
+      data.insert(data.end(), s.begin(), s.end());
+   }
+
+   void bin(const char* p, size_t size) {
+      head(2, size);
+      data.insert(data.end(), p, p + size);
+   }
+
+   void array(uint32_t size) { head(4, size); }
+
+   // Writes the header of a map of at most max entries; end_map fills in its size. Returns the header's position.
+   size_t begin_map(uint32_t max) {
+      auto pos = data.size();
+      head(5, max);
+      return pos;
+   }
+
+   void end_map(size_t pos, uint32_t size) {
+      auto info = uint8_t(data[pos]) & 0x1f;
+      int  n    = info < 24 ? 0 : 1 << (info - 24);
+      if (!n)
+         data[pos] = char(0xa0 | size);
+      for (int i = 0; i < n; ++i)
+         data[pos + 1 + i] = char(uint64_t(size) >> (n - 1 - i) * 8);
+   }
+};
+
+} // namespace eosio
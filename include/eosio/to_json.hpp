@@ -3,6 +3,7 @@
 #include <cmath>
 #include "for_each_field.hpp"
 #include "fpconv.h"
+#include "hex.hpp"
 #include "stream.hpp"
 #include "types.hpp"
 #include <limits>
@@ -11,6 +12,11 @@
 #include <variant>
 #include <map>
 
+#if defined(__SSE2__)
+#   include <immintrin.h>
+#   define EOSIO_TO_JSON_X86
+#endif
+
 namespace eosio {
 
 inline constexpr char hex_digits[] = "0123456789ABCDEF";
@@ -28,16 +34,75 @@ struct stream_adaptor {
    int  idx = 0;
 };
 
+// The length of the run at the start of [p, end) of printable ascii other than '"' and '\\': the bytes json
+// strings hold as they are
+inline std::size_t json_plain_length_scalar(const char* p, const char* end) {
+   auto* pos = p;
+   while (pos != end && *pos != '"' && *pos != '\\' && (unsigned char)(*pos) >= 32 && (unsigned char)(*pos) < 127)
+      ++pos;
+   return pos - p;
+}
+
+#ifdef EOSIO_TO_JSON_X86
+inline std::size_t json_plain_length_sse2(const char* p, const char* end) {
+   auto* pos = p;
+   for (; end - pos >= 16; pos += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+      // signed: bytes from 0x80 up are negative
+      __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmplt_epi8(v, _mm_set1_epi8(0x20)), _mm_cmpeq_epi8(v, _mm_set1_epi8(127))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+      if (int mask = _mm_movemask_epi8(special))
+         return pos - p + __builtin_ctz(mask);
+   }
+   return pos - p + json_plain_length_scalar(pos, end);
+}
+
+__attribute__((target("avx2"))) inline std::size_t json_plain_length_avx2(const char* p, const char* end) {
+   auto* pos = p;
+   for (; end - pos >= 32; pos += 32) {
+      __m256i v       = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+      __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(127))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+      if (uint32_t mask = _mm256_movemask_epi8(special))
+         return pos - p + __builtin_ctz(mask);
+   }
+   return pos - p + json_plain_length_sse2(pos, end);
+}
+#endif
+
+inline std::size_t json_plain_length(const char* p, const char* end) {
+#ifdef EOSIO_TO_JSON_X86
+   static const bool avx2 = __builtin_cpu_supports("avx2");
+   return avx2 ? json_plain_length_avx2(p, end) : json_plain_length_sse2(p, end);
+#else
+   return json_plain_length_scalar(p, end);
+#endif
+}
+
 // Replaces any invalid utf-8 bytes with ?
 template <typename S>
 void to_json(std::string_view sv, S& stream) {
    stream.write('"');
-   auto begin = sv.begin();
-   auto end   = sv.end();
+   auto begin = sv.data();
+   auto end   = sv.data() + sv.size();
    while (begin != end) {
+      // Printable ascii goes out in one write. The bytes from 0x80 up, and any ascii between them, are validated
+      // as utf-8 up to the next byte which needs an escape.
+      auto plain = begin + json_plain_length(begin, end);
+      if (plain != begin) {
+         stream.write(begin, plain - begin);
+         begin = plain;
+      }
       auto pos = begin;
-      while (pos != end && *pos != '"' && *pos != '\\' && (unsigned char)(*pos) >= 32 && *pos != 127) ++pos;
+      while (pos != end && (unsigned char)(*pos) >= 0x80) pos += 1 + json_plain_length(pos + 1, end);
       while (begin != pos) {
+         if (auto plain = begin + json_plain_length(begin, pos); plain != begin) {
+            stream.write(begin, plain - begin);
+            begin = plain;
+            continue;
+         }
          stream_adaptor s2(begin, static_cast<std::size_t>(pos - begin));
          if (rapidjson::UTF8<>::Validate(s2, s2)) {
             stream.write(begin, s2.idx);
@@ -293,10 +358,13 @@ void to_json(const T& t, S& stream) {
 template <typename S>
 void to_json_hex(const char* data, size_t size, S& stream) {
    stream.write('"');
-   for (size_t i = 0; i < size; ++i) {
-      unsigned char byte = data[i];
-      stream.write(hex_digits[byte >> 4]);
-      stream.write(hex_digits[byte & 15]);
+   char buffer[512];
+   while (size) {
+      size_t n = std::min(size, sizeof(buffer) / 2);
+      hex_encode(data, n, buffer);
+      stream.write(buffer, 2 * n);
+      data += n;
+      size -= n;
    }
    stream.write('"');
 }
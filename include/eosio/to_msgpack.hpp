@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace eosio {
+
+// Writes MessagePack (https://github.com/msgpack/msgpack/blob/master/spec.md) values to data, each in its
+// shortest form. Maps are written with begin_map and end_map, so their size may be known only at their end.
+struct msgpack_writer {
+   std::vector<char>& data;
+
+   void write(uint8_t b) { data.push_back(char(b)); }
+
+   // Writes the low n bytes of v, big-endian
+   void write_be(uint64_t v, int n) {
+      for (int shift = (n - 1) * 8; shift >= 0; shift -= 8)
+         data.push_back(char(v >> shift));
+   }
+
+   void nil() { write(0xc0); }
+   void boolean(bool v) { write(v ? 0xc3 : 0xc2); }
+
+   void uint(uint64_t v) {
+      if (v < 0x80)
+         write(uint8_t(v));
+      else if (v <= 0xff)
+         write(0xcc), write_be(v, 1);
+      else if (v <= 0xffff)
+         write(0xcd), write_be(v, 2);
+      else if (v <= 0xffff'ffff)
+         write(0xce), write_be(v, 4);
+      else
+         write(0xcf), write_be(v, 8);
+   }
+
+   void sint(int64_t v) {
+      if (v >= 0)
+         uint(v);
+      else if (v >= -32)
+         write(uint8_t(v));
+      else if (v >= INT8_MIN)
+         write(0xd0), write_be(v, 1);
+      else if (v >= INT16_MIN)
+         write(0xd1), write_be(v, 2);
+      else if (v >= INT32_MIN)
+         write(0xd2), write_be(v, 4);
+      else
+         write(0xd3), write_be(v, 8);
+   }
+
+   void f32(float v) {
+      uint32_t bits;
+      memcpy(&bits, &v, sizeof(bits));
+      write(0xca), write_be(bits, 4);
+   }
+
+   void f64(double v) {
+      uint64_t bits;
+      memcpy(&bits, &v, sizeof(bits));
+      write(0xcb), write_be(bits, 8);
+   }
+
+   void str(std::string_view s) {
+      if (s.size() < 32)
+         write(uint8_t(0xa0 | s.size()));
+      else if (s.size() <= 0xff)
+         write(0xd9), write_be(s.size(), 1);
+      else if (s.size() <= 0xffff)
+         write(0xda), write_be(s.size(), 2);
+      else
+         write(0xdb), write_be(s.size(), 4);
+      data.insert(data.end(), s.begin(), s.end());
+   }
+
+   void bin(const char* p, size_t size) {
+      if (size <= 0xff)
+         write(0xc4), write_be(size, 1);
+      else if (size <= 0xffff)
+         write(0xc5), write_be(size, 2);
+      else
+         write(0xc6), write_be(size, 4);
+      data.insert(data.end(), p, p + size);
+   }
+
+   void array(uint32_t size) {
+      if (size < 16)
+         write(uint8_t(0x90 | size));
+      else if (size <= 0xffff)
+         write(0xdc), write_be(size, 2);
+      else
+         write(0xdd), write_be(size, 4);
+   }
+
+   // Writes the header of a map of at most max entries; end_map fills in its size. Returns the header's position.
+   size_t begin_map(uint32_t max) {
+      auto pos = data.size();
+      if (max < 16)
+         write(0x80);
+      else if (max <= 0xffff)
+         write(0xde), write_be(0, 2);
+      else
+         write(0xdf), write_be(0, 4);
+      return pos;
+   }
+
+   void end_map(size_t pos, uint32_t size) {
+      auto head = uint8_t(data[pos]);
+      int  n    = head == 0xde ? 2 : head == 0xdf ? 4 : 0;
+      if (!n)
+         data[pos] = char(0x80 | size);
+      for (int i = 0; i < n; ++i)
+         data[pos + 1 + i] = char(size >> (n - 1 - i) * 8);
+   }
+};
+
+} // namespace eosio
@@ -1,6 +1,8 @@
 #include <eosio/abi.hpp>
 #include "abieos.hpp"
 
+#include <set>
+
 using namespace eosio;
 
 namespace {
@@ -20,16 +22,51 @@ struct abi_serializer_impl : abi_serializer {
                              bool start) const override {
         return ::abieos::json_to_bin((T*)nullptr, state, allow_extensions, type, start);
     }
-    void bin_to_json(::abieos::bin_to_json_state& state, bool allow_extensions, const abi_type* type,
-                             bool start) const override {
-        return ::abieos::bin_to_json((T*)nullptr, state, allow_extensions, type, start);
+    void bin_to_json(::abieos::bin_to_json_state& state, bool allow_extensions,
+                             const abi_type* type) const override {
+        return ::abieos::bin_to_json((T*)nullptr, state, allow_extensions, type);
+    }
+    void bin_to_json(::abieos::bin_to_json_buf_state& state, bool allow_extensions,
+                             const abi_type* type) const override {
+        return ::abieos::bin_to_json((T*)nullptr, state, allow_extensions, type);
+    }
+    void bin_to_binary(::abieos::bin_to_msgpack_state& state, bool allow_extensions,
+                             const abi_type* type) const override {
+        return ::abieos::bin_to_binary((T*)nullptr, state, allow_extensions, type);
+    }
+    void bin_to_binary(::abieos::bin_to_cbor_state& state, bool allow_extensions,
+                             const abi_type* type) const override {
+        return ::abieos::bin_to_binary((T*)nullptr, state, allow_extensions, type);
+    }
+    void skip_bin(eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                             size_t depth) const override {
+        return ::abieos::skip_bin((T*)nullptr, bin, allow_extensions, type, depth);
+    }
+    void array_bin_to_json(::abieos::bin_to_json_state& state, const abi_type* type,
+                             uint32_t size) const override {
+        return ::abieos::array_bin_to_json((T*)nullptr, state, type, size);
+    }
+    void array_bin_to_json(::abieos::bin_to_json_buf_state& state, const abi_type* type,
+                             uint32_t size) const override {
+        return ::abieos::array_bin_to_json((T*)nullptr, state, type, size);
+    }
+    uint32_t array_json_to_bin(::abieos::json_to_bin_state& state, const abi_type* type) const override {
+        return ::abieos::array_json_to_bin((T*)nullptr, state, type);
     }
 };
 
 template <typename T>
 constexpr auto abi_serializer_for = abi_serializer_impl<T>{};
 
-abi_type::alias resolve(std::map<std::string, abi_type>& abi_types, const abi_type::alias_def* type, int depth);
+// Where resolution looks up types and adds optional, array and extension types. Eager conversion adds them to
+// abi_types itself; lazy resolution adds them to a separate map, so abi_types keeps its shape while other
+// threads search it.
+struct type_table {
+    std::map<std::string, abi_type>& abi_types;
+    std::map<std::string, abi_type>& derived;
+};
+
+abi_type::alias resolve(type_table& types, const abi_type::alias_def* type, int depth);
 
 template<typename... T, typename... A>
 bool holds_any_alternative(const std::variant<A...>& v) {
@@ -43,45 +80,81 @@ constexpr void for_each_abi_type(F f) {
     std::apply([&f](auto&& ...t) { (f(&t), ...); }, basic_abi_types{});
 }
 
-abi_type* get_type(std::map<std::string, abi_type>& abi_types, const std::string& name, int depth) {
+// The size in binary of every value of T, or 0 if it varies
+template <typename T>
+uint32_t fixed_bin_size(T*) {
+    if constexpr (std::is_same_v<T, varuint32> || std::is_same_v<T, varint32> || std::is_same_v<T, bytes> ||
+                  std::is_same_v<T, std::string> || std::is_same_v<T, public_key> ||
+                  std::is_same_v<T, private_key> || std::is_same_v<T, signature>) {
+        return 0;
+    } else {
+        size_stream ss;
+        to_bin(T{}, ss);
+        return ss.size;
+    }
+}
+
+// Adds `name` to `dest` if it is an optional (T?), array (T[]) or extension (T$) of a type returned by
+// `get_base`, and to `added` if that is set. Returns nullptr if `name` has none of these suffixes.
+template <typename F>
+abi_type* add_derived_type(std::map<std::string, abi_type>& dest, const std::string& name,
+                           std::vector<const abi_type*>* added, F&& get_base) {
+    if (ends_with(name, "?")) {
+        abi_type* base = get_base(name.substr(0, name.size() - 1));
+        // removed abi_type::array from invalid types for nesting, optional array should work
+        eosio::check(
+            !holds_any_alternative<abi_type::optional, abi_type::extension>(base->_data),
+            "Invalid optional nesting for type: " + name
+        );
+        auto [iter, success] = dest.try_emplace(name, name, abi_type::optional{base}, &abi_serializer_for< ::abieos::pseudo_optional>);
+        if (success && added)
+            added->push_back(&iter->second);
+        return &iter->second;
+    } else if (ends_with(name, "[]")) {
+        abi_type* element = get_base(name.substr(0, name.size() - 2));
+        // removed abi_type::array from invalid types for nesting, array of arrays should work
+        eosio::check(
+            !holds_any_alternative<abi_type::optional, abi_type::extension>(element->_data),
+            "Invalid array nesting for type: " + name
+        );
+        auto [iter, success] = dest.try_emplace(name, name, abi_type::array{element}, &abi_serializer_for< ::abieos::pseudo_array>);
+        if (success && added)
+            added->push_back(&iter->second);
+        return &iter->second;
+    } else if (ends_with(name, "$")) {
+        abi_type* base = get_base(name.substr(0, name.size() - 1));
+        eosio::check(
+            !std::holds_alternative<abi_type::extension>(base->_data),
+            "Invalid extension nesting for type: " + name
+        );
+        auto [iter, success] = dest.try_emplace(name, name, abi_type::extension{base}, &abi_serializer_for< ::abieos::pseudo_extension>);
+        if (success && added)
+            added->push_back(&iter->second);
+        return &iter->second;
+    }
+    return nullptr;
+}
+
+abi_type* get_type(type_table& types, const std::string& name, int depth) {
     eosio::check(depth < 32, eosio::convert_abi_error(abi_error::recursion_limit_reached));
-    auto it = abi_types.find(name);
-    if (it == abi_types.end()) {
-        if (ends_with(name, "?")) {
-            auto base = get_type(abi_types, name.substr(0, name.size() - 1), depth + 1);
-            // removed abi_type::array from invalid types for nesting, optional array should work
-            eosio::check(
-                !holds_any_alternative<abi_type::optional, abi_type::extension>(base->_data),
-                "Invalid optional nesting for type: " + name
-            );
-            auto [iter, success] = abi_types.try_emplace(name, name, abi_type::optional{base}, &abi_serializer_for< ::abieos::pseudo_optional>);
-            return &iter->second;
-        } else if (ends_with(name, "[]")) {
-            auto element = get_type(abi_types, name.substr(0, name.size() - 2), depth + 1);
-            // removed abi_type::array from invalid types for nesting, array of arrays should work
-            eosio::check(
-                !holds_any_alternative<abi_type::optional, abi_type::extension>(element->_data),
-                "Invalid array nesting for type: " + name
-            );
-            auto [iter, success] = abi_types.try_emplace(name, name, abi_type::array{element}, &abi_serializer_for< ::abieos::pseudo_array>);
-            return &iter->second;
-        } else if (ends_with(name, "$")) {
-            auto base = get_type(abi_types, name.substr(0, name.size() - 1), depth + 1);
-            eosio::check(
-                !std::holds_alternative<abi_type::extension>(base->_data),
-                "Invalid extension nesting for type: " + name
-            );
-            auto [iter, success] = abi_types.try_emplace(name, name, abi_type::extension{base}, &abi_serializer_for< ::abieos::pseudo_extension>);
-            return &iter->second;
-        } else
-           EOS_CHECK(false, std::string(eosio::convert_abi_error(abi_error::unknown_type)) + " of " + name);
+    auto it = types.abi_types.find(name);
+    if (it == types.abi_types.end()) {
+        if (&types.derived != &types.abi_types) {
+            if (auto d = types.derived.find(name); d != types.derived.end())
+                return &d->second;
+        }
+        auto* derived = add_derived_type(types.derived, name, nullptr, [&](const std::string& base) {
+            return get_type(types, base, depth + 1);
+        });
+        EOS_CHECK(derived, std::string(eosio::convert_abi_error(abi_error::unknown_type)) + " of " + name);
+        return derived;
     }
 
     // resolve aliases
     if (auto* alias = std::get_if<abi_type::alias>(&it->second._data)) {
         return alias->type;
     } else if(auto* alias = std::get_if<const abi_type::alias_def*>(&it->second._data)) {
-        auto base = resolve(abi_types, *alias, depth);
+        auto base = resolve(types, *alias, depth);
         it->second._data = base;
         return base.type;
     }
@@ -89,15 +162,15 @@ abi_type* get_type(std::map<std::string, abi_type>& abi_types, const std::string
     return &it->second;
 }
 
-abi_type::struct_ resolve(std::map<std::string, abi_type>& abi_types, const struct_def* type, int depth) {
+abi_type::struct_ resolve(type_table& types, const struct_def* type, int depth) {
    eosio::check(depth < 32,
         eosio::convert_abi_error(abi_error::recursion_limit_reached));
     abi_type::struct_ result;
     if (!type->base.empty()) {
-        auto base = get_type(abi_types, type->base, depth + 1);
+        auto base = get_type(types, type->base, depth + 1);
 
         if(auto* base_def = std::get_if<const struct_def*>(&base->_data)) {
-            auto b = resolve(abi_types, *base_def, depth + 1);
+            auto b = resolve(types, *base_def, depth + 1);
             base->_data = std::move(b);
         }
         if(auto* b = std::get_if<abi_type::struct_>(&base->_data)) {
@@ -107,38 +180,40 @@ abi_type::struct_ resolve(std::map<std::string, abi_type>& abi_types, const stru
         }
     }
     for (auto& field : type->fields) {
-        auto t = get_type(abi_types, field.type, depth + 1);
+        auto t = get_type(types, field.type, depth + 1);
         result.fields.push_back(abi_field{field.name, t});
     }
+    result.index_fields();
     return result;
 }
 
 
-abi_type::variant resolve(std::map<std::string, abi_type>& abi_types, const variant_def* type, int depth) {
+abi_type::variant resolve(type_table& types, const variant_def* type, int depth) {
    eosio::check(depth < 32,
         eosio::convert_abi_error(abi_error::recursion_limit_reached));
     abi_type::variant result;
     for (const std::string& field : type->types) {
-        auto t = get_type(abi_types, field, depth + 1);
+        auto t = get_type(types, field, depth + 1);
         result.push_back({field, t});
     }
+    result.index_alternatives();
     return result;
 }
 
-abi_type::alias resolve(std::map<std::string, abi_type>& abi_types, const abi_type::alias_def* type, int depth) {
-    auto t = get_type(abi_types, *type, depth + 1);
+abi_type::alias resolve(type_table& types, const abi_type::alias_def* type, int depth) {
+    auto t = get_type(types, *type, depth + 1);
     eosio::check(!std::holds_alternative<abi_type::extension>(t->_data),
         eosio::convert_abi_error(abi_error::extension_typedef));
     return abi_type::alias{t};
 }
 
 struct fill_t {
-   std::map<std::string, abi_type>& abi_types;
+   type_table& types;
    abi_type& type;
    int depth;
    template<typename T>
-   auto operator()(T& t) -> std::void_t<decltype(resolve(abi_types, t, depth))> {
-      auto x = resolve(abi_types, t, depth);
+   auto operator()(T& t) -> std::void_t<decltype(resolve(types, t, depth))> {
+      auto x = resolve(types, t, depth);
       type._data = std::move(x);
    }
    template<typename T>
@@ -146,18 +221,123 @@ struct fill_t {
    }
 };
 
-void fill(std::map<std::string, abi_type>& abi_types, abi_type& type, int depth) {
-   return std::visit(fill_t{abi_types, type, depth}, type._data);
+void fill(type_table& types, abi_type& type, int depth) {
+   return std::visit(fill_t{types, type, depth}, type._data);
+}
+
+// Resolves type and every type reachable from it, compiles their programs, then marks them all resolved and
+// appends them to added, if it is set
+void resolve_all(type_table& types, abi_type* type, std::vector<const abi_type*>* added) {
+    if (type->resolved.load(std::memory_order_relaxed))
+        return;
+    std::vector<abi_type*> pending{type};
+    std::vector<abi_type*> done;
+    std::set<abi_type*> seen{type};
+    // abi_type links are non-const only so that resolution can fill them in
+    auto add = [&](const abi_type* t) {
+        if (t && !t->resolved.load(std::memory_order_relaxed) && seen.insert(const_cast<abi_type*>(t)).second)
+            pending.push_back(const_cast<abi_type*>(t));
+    };
+    while (!pending.empty()) {
+        auto* t = pending.back();
+        pending.pop_back();
+        fill(types, *t, 0);
+        done.push_back(t);
+        if (auto* s = t->as_struct()) {
+            add(s->base);
+            for (auto& field : s->fields)
+                add(field.type);
+        } else if (auto* v = t->as_variant()) {
+            for (auto& field : *v)
+                add(field.type);
+        } else if (auto* alias = std::get_if<abi_type::alias>(&t->_data)) {
+            add(alias->type);
+        } else {
+            add(t->optional_of());
+            add(t->array_of());
+            add(t->extension_of());
+        }
+    }
+    // compiled before other threads can find them, so the program is complete when its memory is counted
+    for (auto* t : done)
+        if (!std::holds_alternative<abi_type::alias>(t->_data))
+            t->program();
+    for (auto* t : done)
+        t->resolved.store(true, std::memory_order_release);
+    if (added)
+        added->insert(added->end(), done.begin(), done.end());
+}
+
+const abi_type* find_type(const std::map<std::string, abi_type>& abi_types, const std::string& name, bool lazy) {
+    auto it = abi_types.find(name);
+    if (it == abi_types.end())
+        return nullptr;
+    if (lazy && !it->second.resolved.load(std::memory_order_acquire))
+        return nullptr;
+    if (auto* alias = std::get_if<abi_type::alias>(&it->second._data))
+        return alias->type;
+    return &it->second;
+}
+
+const abi_type* find_type(const std::map<std::string, abi_type>& abi_types, std::map<std::string, abi_type>& derived,
+                          std::vector<const abi_type*>* added, const std::string& name, int depth) {
+    eosio::check(depth < 32, eosio::convert_abi_error(abi_error::recursion_limit_reached));
+    if (auto* t = find_type(abi_types, name, false))
+        return t;
+    if (auto it = derived.find(name); it != derived.end())
+        return &it->second;
+    auto* result = add_derived_type(derived, name, added, [&](const std::string& base) {
+        // abi_type links are non-const only so that convert() can fill them in
+        return const_cast<abi_type*>(find_type(abi_types, derived, added, base, depth + 1));
+    });
+    EOS_CHECK(result, std::string(eosio::convert_abi_error(abi_error::unknown_type)) + " of " + name);
+    return result;
 }
 
 }
 
 
 const abi_type* eosio::abi::get_type(const std::string& name) {
-   return ::get_type(abi_types, name, 0);
+   type_table types{abi_types, abi_types};
+   auto* t = ::get_type(types, name, 0);
+   if (lazy_def)
+      resolve_all(types, t, nullptr);
+   return t;
 }
 
-void eosio::convert(const abi_def& abi, eosio::abi& c) {
+const abi_type* eosio::abi::find_type(const std::string& name) const {
+   return ::find_type(abi_types, name, lazy_def != nullptr);
+}
+
+const abi_type* eosio::abi::get_type(const std::string& name, std::map<std::string, abi_type>& derived,
+                                     std::vector<const abi_type*>& added) {
+   if (!lazy_def) {
+      auto first = added.size();
+      auto* t = ::find_type(abi_types, derived, &added, name, 0);
+      for (auto i = first; i < added.size(); ++i)
+         added[i]->program();
+      return t;
+   }
+   type_table types{abi_types, derived};
+   auto* t = ::get_type(types, name, 0);
+   resolve_all(types, t, &added);
+   // let find_type answer for the alias too
+   if (auto it = abi_types.find(name); it != abi_types.end() && &it->second != t)
+      it->second.resolved.store(true, std::memory_order_release);
+   return t;
+}
+
+void eosio::abi::validate(std::map<std::string, abi_type>& derived) {
+   if (!lazy_def)
+      return;
+   std::vector<const abi_type*> added;
+   for (auto& [name, _] : abi_types)
+      get_type(name, derived, added);
+}
+
+namespace {
+
+void add_definitions(const abi_def& abi, eosio::abi& c) {
     for (auto& a : abi.actions)
         c.action_types[a.name] = a.type;
     for (auto& t : abi.tables)
@@ -166,12 +346,15 @@ void eosio::convert(const abi_def& abi, eosio::abi& c) {
         c.action_result_types[r.name] = r.result_type;
     for_each_abi_type([&](auto* p) {
         const char* name = get_type_name(p);
-        c.abi_types.try_emplace(name, name, abi_type::builtin{}, &abi_serializer_for<std::decay_t<decltype(*p)>>);
+        auto [it, inserted] =
+            c.abi_types.try_emplace(name, name, abi_type::builtin{}, &abi_serializer_for<std::decay_t<decltype(*p)>>);
+        it->second.fixed_size = fixed_bin_size(p);
     });
     {
-        c.abi_types.try_emplace("extended_asset", "extended_asset",
-                                abi_type::struct_{nullptr, {{"quantity", &c.abi_types.find("asset")->second},
-                                                            {"contract", &c.abi_types.find("name")->second}}},
+        abi_type::struct_ extended_asset{nullptr, {{"quantity", &c.abi_types.find("asset")->second},
+                                                   {"contract", &c.abi_types.find("name")->second}}};
+        extended_asset.index_fields();
+        c.abi_types.try_emplace("extended_asset", "extended_asset", std::move(extended_asset),
                                 &abi_serializer_for<::abieos::pseudo_object>);
     }
 
@@ -196,9 +379,120 @@ void eosio::convert(const abi_def& abi, eosio::abi& c) {
         eosio::check(inserted,
             eosio::convert_abi_error(abi_error::redefined_type));
     }
+}
+
+}
+
+namespace {
+
+// Nested structs are compiled inline up to this depth, and while the program is shorter than max_inline_ops
+constexpr size_t max_inline_depth = 4;
+constexpr size_t max_inline_ops = 256;
+
+struct program_builder {
+    std::vector<abi_op>& ops;
+    std::vector<const abi_type*> inlined{};
+
+    bool can_inline(const abi_type* type) const {
+        return inlined.size() < max_inline_depth && ops.size() < max_inline_ops &&
+               std::find(inlined.begin(), inlined.end(), type) == inlined.end();
+    }
+
+    void value(const abi_type* type, bool allow) {
+        if (auto* t = type->extension_of())
+            return value(t, allow);
+        if (auto* t = type->optional_of()) {
+            auto at = ops.size();
+            ops.push_back({abi_op::optional, allow});
+            value(t, allow);
+            ops[at].skip = ops.size() - at - 1;
+            return;
+        }
+        if (auto* s = type->as_struct(); s && can_inline(type)) {
+            inlined.push_back(type);
+            ops.push_back({abi_op::begin_object, allow});
+            ops.back().type = type;
+            std::vector<size_t> fields;
+            for (size_t i = 0; i < s->fields.size();) {
+                auto& field = s->fields[i];
+                if (field.type->fixed_size) {
+                    ops.push_back({abi_op::fixed, false, i == 0});
+                    ops.back().type  = type;
+                    ops.back().field = &field;
+                    for (; i < s->fields.size() && s->fields[i].type->fixed_size; ++i) {
+                        ++ops.back().count;
+                        ops.back().size += s->fields[i].type->fixed_size;
+                    }
+                    continue;
+                }
+                auto at = ops.size();
+                fields.push_back(at);
+                ops.push_back({abi_op::key, allow, i == 0});
+                ops.back().field = &field;
+                ++i;
+                value(field.type, allow && i == s->fields.size());
+                ops[at].skip = ops.size() - at - 1;
+            }
+            ops.push_back({abi_op::end_object, allow});
+            ops.back().type = type;
+            for (auto at : fields)
+                ops[at].end = ops.size() - at;
+            inlined.pop_back();
+            return;
+        }
+        if (auto* t = type->array_of(); t && (t->is_builtin() || abieos::fixed_layout(t))) {
+            ops.push_back({abi_op::array, allow, true});
+            ops.back().type = type;
+            ops.back().size = t->is_builtin() ? t->fixed_size : abieos::fixed_layout(t);
+            return;
+        }
+        ops.push_back({type->is_builtin() ? abi_op::builtin : abi_op::call, allow});
+        ops.back().type = type;
+    }
+};
+
+} // namespace
+
+eosio::abi_field::abi_field(std::string name, const abi_type* type) : name(std::move(name)), type(type) {
+    std::vector<char> key;
+    vector_stream stream{key};
+    to_json(this->name, stream);
+    stream.write(':');
+    json_key.assign(key.begin(), key.end());
+}
+
+const abi_program& eosio::abi_type::program() const {
+    std::call_once(compiled_once, [&] {
+        auto& ops = compiled.ops;
+        if (auto* t = array_of()) {
+            ops.push_back({abi_op::array, true, t->is_builtin() || abieos::fixed_layout(t)});
+            ops.back().type = this;
+            ops.back().size = t->is_builtin() ? t->fixed_size : abieos::fixed_layout(t);
+        } else if (as_variant()) {
+            ops.push_back({abi_op::variant, true});
+            ops.back().type = this;
+        } else {
+            program_builder{ops}.value(this, true);
+        }
+        ops.shrink_to_fit();
+    });
+    return compiled;
+}
+
+void eosio::convert(const abi_def& abi, eosio::abi& c) {
+    add_definitions(abi, c);
+    type_table types{c.abi_types, c.abi_types};
     for (auto& [_, t] : c.abi_types) {
-        fill(c.abi_types, t, 0);
+        fill(types, t, 0);
     }
+    for (auto& [_, t] : c.abi_types)
+        if (!std::holds_alternative<abi_type::alias>(t._data))
+            t.program();
+}
+
+void eosio::convert_lazy(std::shared_ptr<const abi_def> def, eosio::abi& c) {
+    add_definitions(*def, c);
+    c.lazy_def = std::move(def);
 }
 
 void to_abi_def(abi_def& def, const std::string& name, const abi_type::builtin&) {}
@@ -233,8 +527,8 @@ void to_abi_def(abi_def& def, const std::string& name, const abi_type::struct_&
 
 void to_abi_def(abi_def& def, const std::string& name, const abi_type::variant& variant) {
    std::vector<std::string> types;
-   for(const auto& [name, type] : variant) {
-      types.push_back(type->name);
+   for(const auto& alternative : variant) {
+      types.push_back(alternative.type->name);
    }
    def.variants.value.push_back({name, std::move(types)});
 }
@@ -253,10 +547,12 @@ const abi_serializer* const eosio::extension_abi_serializer = &abi_serializer_fo
 const abi_serializer* const eosio::optional_abi_serializer = &abi_serializer_for< ::abieos::pseudo_optional>;
 
 std::vector<char> eosio::abi_type::json_to_bin_reorderable(std::string_view json, std::function<void()> f) const {
-   abieos::jvalue tmp;
-   abieos::json_to_jvalue(tmp, json, f);
+   std::string mutable_json{json};
+   mutable_json.append(3, '\0');
+   abieos::json_arena arena;
+   auto& value = abieos::json_to_jvalue(arena, mutable_json.data(), f);
    std::vector<char> result;
-   abieos::json_to_bin(result, this, tmp, f);
+   abieos::json_to_bin(result, this, value, f);
    return result;
 }
 
@@ -266,8 +562,358 @@ std::vector<char> eosio::abi_type::json_to_bin(std::string_view json, std::funct
    return result;
 }
 
+void eosio::abi_type::skip(input_stream& bin) const {
+   abieos::skip_bin(bin, true, this, 0);
+}
+
+std::vector<char> eosio::abi_type::bin_to_msgpack(input_stream& bin, std::function<void()> f) const {
+   std::vector<char> result;
+   abieos::bin_to_binary<msgpack_writer>(bin, this, result, f);
+   return result;
+}
+
+std::vector<char> eosio::abi_type::bin_to_cbor(input_stream& bin, std::function<void()> f) const {
+   std::vector<char> result;
+   abieos::bin_to_binary<cbor_writer>(bin, this, result, f);
+   return result;
+}
+
 std::string eosio::abi_type::bin_to_json(input_stream& bin, std::function<void()> f) const {
    std::string result;
    abieos::bin_to_json(bin, this, result, f);
    return result;
 }
+
+namespace {
+
+// Removes the '.' after a step of a projection path: a field's name or an array's "[]". Returns false if the path
+// is malformed.
+bool end_step(std::string_view& path) {
+    if (path.empty() || path[0] == '[')
+        return true;
+    if (path[0] != '.' || path.size() == 1)
+        return false;
+    path.remove_prefix(1);
+    return true;
+}
+
+// Whether path selects anything within a value of type
+bool projection_resolves(const abi_type* type, std::string_view path, int depth) {
+    eosio::check(depth < 32, eosio::convert_abi_error(abi_error::recursion_limit_reached));
+    if (path.empty())
+        return true;
+    if (auto* t = type->optional_of())
+        return projection_resolves(t, path, depth + 1);
+    if (auto* t = type->extension_of())
+        return projection_resolves(t, path, depth + 1);
+    if (auto* v = type->as_variant()) {
+        for (auto& alternative : *v)
+            if (projection_resolves(alternative.type, path, depth + 1))
+                return true;
+        return false;
+    }
+    if (auto* t = type->array_of()) {
+        if (path.substr(0, 2) != "[]")
+            return false;
+        path.remove_prefix(2);
+        return end_step(path) && projection_resolves(t, path, depth + 1);
+    }
+    auto* s = type->as_struct();
+    if (!s)
+        return false;
+    auto name = path.substr(0, path.find_first_of(".["));
+    if (name.empty())
+        return false;
+    path.remove_prefix(name.size());
+    if (!end_step(path))
+        return false;
+    const abi_field* field = nullptr;
+    s->find_fields(name, [&](uint32_t i) {
+        if (!field)
+            field = &s->fields[i];
+    });
+    return field && projection_resolves(field->type, path, depth + 1);
+}
+
+struct projection_builder {
+    std::vector<abi_projection::node>& nodes;
+
+    uint32_t add_node(const abi_type* type) {
+        nodes.push_back({type});
+        return nodes.size() - 1;
+    }
+
+    // Adds path, which projection_resolves accepts, to node n
+    void add(uint32_t n, std::string_view path) {
+        if (nodes[n].whole)
+            return;
+        if (path.empty()) {
+            nodes[n].whole = true;
+            return;
+        }
+        auto* type = nodes[n].type;
+        if (auto* t = type->optional_of() ? type->optional_of() : type->extension_of()) {
+            if (!nodes[n].inner) {
+                auto inner = add_node(t);
+                nodes[n].inner = inner;
+            }
+            return add(nodes[n].inner, path);
+        }
+        if (auto* v = type->as_variant()) {
+            nodes[n].alternatives.resize(v->size());
+            for (uint32_t i = 0; i < v->size(); ++i) {
+                auto* t = (*v)[i].type;
+                if (!projection_resolves(t, path, 0))
+                    continue;
+                if (!nodes[n].alternatives[i]) {
+                    auto alternative = add_node(t);
+                    nodes[n].alternatives[i] = alternative;
+                }
+                add(nodes[n].alternatives[i], path);
+            }
+            return;
+        }
+        if (auto* t = type->array_of()) {
+            path.remove_prefix(2);
+            end_step(path);
+            if (!nodes[n].inner) {
+                auto inner = add_node(t);
+                nodes[n].inner = inner;
+            }
+            return add(nodes[n].inner, path);
+        }
+        auto* s = type->as_struct();
+        auto name = path.substr(0, path.find_first_of(".["));
+        path.remove_prefix(name.size());
+        end_step(path);
+        uint32_t position = s->fields.size();
+        s->find_fields(name, [&](uint32_t i) { position = std::min(position, i); });
+        auto& fields = nodes[n].fields;
+        size_t at = std::lower_bound(fields.begin(), fields.end(), std::pair{position, uint32_t(0)}) - fields.begin();
+        if (at == fields.size() || fields[at].first != position) {
+            auto field = add_node(s->fields[position].type);
+            nodes[n].fields.insert(nodes[n].fields.begin() + at, {position, field});
+        }
+        add(nodes[n].fields[at].second, path);
+    }
+};
+
+} // namespace
+
+eosio::abi_projection::abi_projection(const abi_type* type, const std::vector<std::string>& paths) {
+    nodes.push_back({type});
+    for (auto& path : paths) {
+        EOS_CHECK(!path.empty() && projection_resolves(type, path, 0),
+                  std::string(convert_abi_error(abi_error::bad_projection)) + ": " + path + " is not in " +
+                        type->name);
+        projection_builder{nodes}.add(0, path);
+    }
+}
+
+std::string eosio::abi_projection::bin_to_json(input_stream& bin, std::function<void()> f) const {
+    std::vector<char> buffer;
+    vector_stream writer{buffer};
+    abieos::projection_to_json(bin, *this, 0, true, writer, f);
+    return {buffer.data(), buffer.size()};
+}
+
+namespace {
+
+struct columns_builder {
+    std::vector<abi_columns::column>& columns;
+    std::vector<abi_columns::node>&   nodes;
+    // The structs being added, which are stored as binary if they hold themselves
+    std::vector<const abi_type*>      open{};
+
+    uint32_t add_node(abi_columns::node::code_t code, const abi_type* type) {
+        nodes.push_back({code, type});
+        return nodes.size() - 1;
+    }
+
+    uint32_t add_column(uint32_t n, abi_columns::column::kind_t kind, const std::string& name, uint32_t width,
+                        uint32_t parent, bool nullable) {
+        columns.push_back({name, kind, nodes[n].type, width, parent, nullable});
+        if (kind != abi_columns::column::fixed)
+            columns.back().offsets.push_back(0);
+        nodes[n].column = columns.size() - 1;
+        return nodes[n].column;
+    }
+
+    uint32_t add(const abi_type* type, const std::string& name, uint32_t parent, bool nullable) {
+        using node   = abi_columns::node;
+        using column = abi_columns::column;
+        if (auto* t = type->optional_of() ? type->optional_of() : type->extension_of()) {
+            auto n     = add_node(type->optional_of() ? node::optional : node::extension, type);
+            auto inner = add(t, name, parent, true);
+            nodes[n].children.push_back(inner);
+            return n;
+        }
+        if (auto* s = type->as_struct(); s && std::find(open.begin(), open.end(), type) == open.end()) {
+            open.push_back(type);
+            auto n = add_node(node::object, type);
+            for (auto& field : s->fields) {
+                auto child = add(field.type, name.empty() ? field.name : name + "." + field.name, parent, nullable);
+                nodes[n].children.push_back(child);
+            }
+            open.pop_back();
+            return n;
+        }
+        if (auto* t = type->array_of()) {
+            auto n     = add_node(node::list, type);
+            auto list  = add_column(n, column::list, name, 0, parent, nullable);
+            auto inner = add(t, name + "[]", list, false);
+            nodes[n].children.push_back(inner);
+            return n;
+        }
+        if (type->fixed_size) {
+            auto n = add_node(node::fixed, type);
+            add_column(n, column::fixed, name, type->fixed_size, parent, nullable);
+            return n;
+        }
+        if (type->name == "varuint32" || type->name == "varint32") {
+            auto n = add_node(type->name == "varuint32" ? node::varuint32 : node::varint32, type);
+            add_column(n, column::fixed, name, 4, parent, nullable);
+            return n;
+        }
+        auto code = type->name == "string" ? node::string : type->name == "bytes" ? node::bytes : node::binary;
+        auto n    = add_node(code, type);
+        add_column(n, column::variable, name, 0, parent, nullable);
+        return n;
+    }
+};
+
+// Decodes a value into the columns, or, if it isn't present, appends nulls
+struct columns_reader {
+    std::vector<abi_columns::column>&     columns;
+    const std::vector<abi_columns::node>& nodes;
+    input_stream&                         bin;
+
+    void value(abi_columns::column& column, bool present) {
+        if (column.nullable)
+            column.validity.push_back(present);
+    }
+
+    void read(uint32_t n, bool present, bool allow_extensions) {
+        using node = abi_columns::node;
+        auto& nd   = nodes[n];
+        switch (nd.code) {
+        case node::fixed: {
+            auto& column = columns[nd.column];
+            value(column, present);
+            if (present) {
+                bin.check_available(column.width);
+                column.data.insert(column.data.end(), bin.pos, bin.pos + column.width);
+                bin.pos += column.width;
+            } else {
+                column.data.resize(column.data.size() + column.width);
+            }
+            return;
+        }
+        case node::varuint32:
+        case node::varint32: {
+            auto& column = columns[nd.column];
+            value(column, present);
+            uint32_t v = 0;
+            if (present && nd.code == node::varuint32) {
+                varuint32_from_bin(v, bin);
+            } else if (present) {
+                int32_t s;
+                varint32_from_bin(s, bin);
+                v = s;
+            }
+            char bytes[4] = {char(v), char(v >> 8), char(v >> 16), char(v >> 24)};
+            column.data.insert(column.data.end(), bytes, bytes + 4);
+            return;
+        }
+        case node::string:
+        case node::bytes:
+        case node::binary: {
+            auto& column = columns[nd.column];
+            value(column, present);
+            if (present && nd.code == node::binary) {
+                auto* begin = bin.pos;
+                abieos::skip_bin(bin, allow_extensions, nd.type, 0);
+                column.data.insert(column.data.end(), begin, bin.pos);
+            } else if (present) {
+                uint64_t size = 0;
+                if (nd.code == node::string) {
+                    uint32_t s;
+                    varuint32_from_bin(s, bin);
+                    size = s;
+                } else {
+                    varuint64_from_bin(size, bin);
+                }
+                bin.check_available(size);
+                column.data.insert(column.data.end(), bin.pos, bin.pos + size);
+                bin.pos += size;
+            }
+            column.offsets.push_back(column.data.size());
+            return;
+        }
+        case node::optional: {
+            bool inner = false;
+            if (present)
+                from_bin(inner, bin);
+            return read(nd.children[0], inner, allow_extensions);
+        }
+        case node::extension:
+            return read(nd.children[0], present, allow_extensions);
+        case node::object: {
+            auto& fields = nd.type->as_struct()->fields;
+            for (size_t i = 0; i < fields.size(); ++i) {
+                bool omitted = present && bin.pos == bin.end && fields[i].type->extension_of() && allow_extensions;
+                read(nd.children[i], present && !omitted, allow_extensions && i + 1 == fields.size());
+            }
+            return;
+        }
+        case node::list: {
+            auto& column = columns[nd.column];
+            value(column, present);
+            uint32_t size = 0;
+            if (present)
+                varuint32_from_bin(size, bin);
+            column.offsets.push_back(column.offsets.back() + size);
+            for (uint32_t i = 0; i < size; ++i)
+                read(nd.children[0], true, false);
+            return;
+        }
+        }
+    }
+};
+
+} // namespace
+
+eosio::abi_columns::abi_columns(const abi_type* type) {
+    columns_builder{columns, nodes}.add(type, "", npos, false);
+}
+
+void eosio::abi_columns::append(input_stream& bin) {
+    struct sizes {
+        size_t data, offsets, validity;
+    };
+    std::vector<sizes> before;
+    before.reserve(columns.size());
+    for (auto& column : columns)
+        before.push_back({column.data.size(), column.offsets.size(), column.validity.size()});
+    try {
+        columns_reader{columns, nodes, bin}.read(0, true, true);
+    } catch (...) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            columns[i].data.resize(before[i].data);
+            columns[i].offsets.resize(before[i].offsets);
+            columns[i].validity.resize(before[i].validity);
+        }
+        throw;
+    }
+    ++rows;
+}
+
+void eosio::abi_columns::clear() {
+    for (auto& column : columns) {
+        column.data.clear();
+        column.validity.clear();
+        if (column.kind != column::fixed)
+            column.offsets.assign(1, 0);
+    }
+    rows = 0;
+}
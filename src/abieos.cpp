@@ -3,17 +3,598 @@
 #include "abieos.h"
 #include "abieos.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace abieos;
 
+// Converts an abi_def, eagerly or lazily (see eosio::convert_lazy)
+void convert_abi(std::shared_ptr<abi_def> def, abi& value, bool lazy) {
+    if (lazy)
+        convert_lazy(std::move(def), value);
+    else
+        convert(*def, value);
+}
+
+// Converts a binary abi_def
+void abi_from_bin(eosio::input_stream bin, abi& value, bool lazy) {
+    std::string error;
+    auto stream = bin;
+    std::string version;
+    from_bin(version, stream);
+    if (!check_abi_version(version, error))
+        throw std::runtime_error(error);
+    auto def = std::make_shared<abi_def>();
+    from_bin(*def, bin);
+    convert_abi(std::move(def), value, lazy);
+}
+
+// A read-only mapping of a whole file. Mappings are shared, so processes mapping the same file share its pages.
+struct mapped_file {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    explicit mapped_file(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error("can't open " + path + ": " + strerror(errno));
+        struct stat st;
+        int err = 0;
+        if (::fstat(fd, &st) != 0) {
+            err = errno;
+        } else if (st.st_size == 0) {
+            err = EINVAL;
+        } else {
+            void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                err = errno;
+            } else {
+                data = static_cast<const char*>(p);
+                size = st.st_size;
+            }
+        }
+        ::close(fd);
+        if (!data)
+            throw std::runtime_error("can't map " + path + ": " + strerror(err));
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() { ::munmap(const_cast<char*>(data), size); }
+};
+
+// Abi cache files hold binary abis, so loading one only maps it; each contract is converted on first use.
+// Layout, little endian:
+//     char     magic[8]                    abi_cache_magic
+//     uint64_t count
+//     struct { uint64_t contract, offset, size; } index[count], sorted by contract
+//     abis, each at offset bytes from the start of the file
+inline constexpr char abi_cache_magic[8] = {'f', 'l', 'o', 'n', 'a', 'b', 'c', '1'};
+
+struct abi_cache_entry {
+    uint64_t contract = 0;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+// Approximate heap memory behind a value, for memory accounting
+size_t heap_size(const std::string& s);
+size_t heap_size(const abi_type& t);
+size_t heap_size(const eosio::abi_field& f);
+template <typename T>
+size_t heap_size(const std::vector<T>& v);
+template <typename A, typename B>
+size_t heap_size(const std::pair<A, B>& p);
+template <typename K, typename V>
+size_t heap_size(const std::map<K, V>& m);
+template <typename T>
+size_t heap_size(const eosio::might_not_exist<T>& v);
+template <typename T>
+size_t heap_size(const T& v);
+
+size_t heap_size(const std::string& s) {
+    // beyond the small string buffer
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+// A program is counted once it is compiled. Types a contract_abi reaches are compiled before other threads can
+// find them, so this never races with their compilation.
+size_t heap_size(const abi_type& t) {
+    size_t result = heap_size(t.name) + heap_size(t.compiled.ops);
+    if (auto* s = t.as_struct())
+        result += heap_size(s->fields) + heap_size(s->index.slots);
+    else if (auto* v = t.as_variant())
+        result += heap_size(static_cast<const std::vector<eosio::abi_field>&>(*v)) + heap_size(v->index.slots);
+    return result;
+}
+
+size_t heap_size(const eosio::abi_field& f) {
+    return heap_size(f.name) + heap_size(f.json_key);
+}
+
+template <typename T>
+size_t heap_size(const std::vector<T>& v) {
+    size_t result = v.capacity() * sizeof(T);
+    for (auto& x : v)
+        result += heap_size(x);
+    return result;
+}
+
+template <typename A, typename B>
+size_t heap_size(const std::pair<A, B>& p) {
+    return heap_size(p.first) + heap_size(p.second);
+}
+
+template <typename K, typename V>
+size_t heap_size(const std::map<K, V>& m) {
+    // tree nodes hold the color and three links
+    size_t result = m.size() * (sizeof(typename std::map<K, V>::value_type) + 4 * sizeof(void*));
+    for (auto& x : m)
+        result += heap_size(x);
+    return result;
+}
+
+template <typename T>
+size_t heap_size(const eosio::might_not_exist<T>& v) {
+    return heap_size(v.value);
+}
+
+template <typename T>
+size_t heap_size(const T& v) {
+    size_t result = 0;
+    if constexpr (eosio::reflection::has_for_each_field_v<T>) {
+        eosio::for_each_field<T>([&](const char*, auto&& member) { result += heap_size(member(&v)); });
+    }
+    return result;
+}
+
+inline uint64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct abi_registry;
+
+// An abi which may be shared by contexts running on different threads. It is immutable once published,
+// except for optional, array and extension types created on demand and for types of lazily converted abis
+// resolved on demand, both guarded by mutex, and for abis loaded from a cache, which are converted once on
+// first use. Types already resolved are found without locking.
+struct contract_abi {
+    abi value{};
+    std::mutex mutex{};
+    std::map<std::string, abi_type> derived{};
+
+    // The binary abi this was converted from, to recognize identical abis
+    std::string source{};
+
+    std::shared_ptr<const mapped_file> cache{};
+    std::string_view cached_bin{};
+    bool lazy = false;
+    std::once_flag converted{};
+
+    // The registry accounting for this abi, and the memory use it last reported there
+    abi_registry* registry = nullptr;
+    size_t bytes = 0;
+    // When a contract last looked this abi up, for least-recently-used eviction
+    std::atomic<uint64_t> last_used{now_ms()};
+
+    void touch() {
+        auto now = now_ms();
+        if (last_used.load(std::memory_order_relaxed) != now)
+            last_used.store(now, std::memory_order_relaxed);
+    }
+
+    size_t memory_usage() const {
+        size_t result = sizeof(*this) + heap_size(source) + heap_size(value.action_types) +
+                        heap_size(value.table_types) + heap_size(value.abi_types) +
+                        heap_size(value.action_result_types) + heap_size(derived);
+        if (value.lazy_def)
+            result += sizeof(abi_def) + heap_size(*value.lazy_def);
+        return result;
+    }
+
+    // Reports memory growth from converting on first use or resolving types lazily
+    void update_usage();
+
+    // Reports the memory of types get_type created or resolved, and of their programs, without walking the rest
+    // of the abi
+    void add_usage(const std::vector<const abi_type*>& added);
+
+    abi& get_abi() {
+        if (cache) {
+            std::call_once(converted, [&] {
+                value = {};
+                abi_from_bin(cached_bin, value, lazy);
+                update_usage();
+            });
+        }
+        return value;
+    }
+
+    const abi_type* get_type(const std::string& name) {
+        auto& a = get_abi();
+        if (auto* t = a.find_type(name))
+            return t;
+        std::lock_guard<std::mutex> lock{mutex};
+        // an optional, array or extension type created before; a lazy abi may have failed to resolve it
+        if (auto it = derived.find(name);
+            it != derived.end() && (!a.lazy_def || it->second.resolved.load(std::memory_order_relaxed)))
+            return &it->second;
+        std::vector<const abi_type*> added;
+        auto* t = a.get_type(name, derived, added);
+        if (!added.empty())
+            add_usage(added);
+        return t;
+    }
+
+    void validate() {
+        auto& a = get_abi();
+        std::lock_guard<std::mutex> lock{mutex};
+        a.validate(derived);
+        update_usage();
+    }
+};
+
+// An abi a contract uses from block_num on, until the block of its next version
+struct abi_version {
+    uint32_t block_num = 0;
+    std::shared_ptr<contract_abi> abi{};
+};
+
+// The set of loaded contracts at some point in time, each with its abi versions ordered by block. Contracts
+// are spread over buckets so publishing a change only copies the affected bucket instead of every loaded
+// contract.
+struct contract_snapshot {
+    using history = std::vector<abi_version>;
+    using bucket = std::map<name, history>;
+    static constexpr size_t num_buckets = 64;
+
+    std::array<std::shared_ptr<const bucket>, num_buckets> buckets;
+
+    contract_snapshot() { buckets.fill(std::make_shared<const bucket>()); }
+
+    static size_t bucket_index(name contract) { return (contract.value * 0x9e37'79b9'7f4a'7c15ull) >> 58; }
+
+    // Looks up a contract's latest abi without counting it as used
+    contract_abi* peek(name contract) const {
+        auto& b = *buckets[bucket_index(contract)];
+        auto it = b.find(contract);
+        if (it == b.end())
+            return nullptr;
+        return it->second.back().abi.get();
+    }
+
+    contract_abi* find(name contract) const {
+        auto* c = peek(contract);
+        if (c)
+            c->touch();
+        return c;
+    }
+
+    // Looks up the abi a contract used at block_num
+    contract_abi* find(name contract, uint32_t block_num) const {
+        auto& b = *buckets[bucket_index(contract)];
+        auto it = b.find(contract);
+        if (it == b.end())
+            return nullptr;
+        auto& h = it->second;
+        auto v = std::upper_bound(h.begin(), h.end(), block_num,
+                                  [](uint32_t block_num, const abi_version& v) { return block_num < v.block_num; });
+        if (v == h.begin())
+            return nullptr;
+        --v;
+        v->abi->touch();
+        return v->abi.get();
+    }
+};
+
+// Abis shared by any number of contexts. Readers pick up the current snapshot without locking. Writers
+// serialize on write_mutex, copy the bucket they change and publish a new snapshot (read-copy-update), so
+// readers never wait for writers and keep using the snapshot they hold until their next call.
+struct abi_registry {
+    std::mutex write_mutex{};
+    std::shared_ptr<const contract_snapshot> snapshot = std::make_shared<const contract_snapshot>();
+    std::atomic<uint64_t> version{1};
+
+    // Converted abis by murmur64 of their binary form, guarded by write_mutex. Expired entries are swept
+    // whenever the map has doubled since the last sweep.
+    std::unordered_multimap<uint64_t, std::weak_ptr<contract_abi>> abis_by_hash{};
+    size_t abis_by_hash_swept = 0;
+
+    // Memory accounting, guarded by write_mutex. users holds the contract versions using each loaded abi;
+    // total_bytes counts each of those abis once.
+    std::unordered_map<const contract_abi*, std::vector<std::pair<name, uint32_t>>> users{};
+    size_t total_bytes = 0;
+    size_t budget = 0;
+    abieos_evict_callback evict_callback = nullptr;
+    void* evict_data = nullptr;
+    // Set when lazily converted abis have grown past the budget; the next lookup evicts
+    std::atomic<bool> over_budget{false};
+
+    std::shared_ptr<const contract_snapshot> load() const { return std::atomic_load(&snapshot); }
+
+    // Like update, with write_mutex already held
+    template <typename F>
+    auto update_locked(F f) {
+        auto next = std::make_shared<contract_snapshot>(*load());
+        std::array<std::shared_ptr<contract_snapshot::bucket>, contract_snapshot::num_buckets> copies;
+        auto result = f([&](name contract) -> contract_snapshot::bucket& {
+            auto index = contract_snapshot::bucket_index(contract);
+            if (!copies[index]) {
+                copies[index] = std::make_shared<contract_snapshot::bucket>(*next->buckets[index]);
+                next->buckets[index] = copies[index];
+            }
+            return *copies[index];
+        });
+        std::atomic_store(&snapshot, std::shared_ptr<const contract_snapshot>{std::move(next)});
+        version.fetch_add(1, std::memory_order_release);
+        return result;
+    }
+
+    // Calls f with a function which returns a private copy of the bucket holding a contract, then publishes
+    // the changes. Only the buckets f asks for are copied. f changes buckets through assign. Returns f's
+    // result.
+    template <typename F>
+    auto update(F f) {
+        std::lock_guard<std::mutex> lock{write_mutex};
+        return update_locked(f);
+    }
+
+    // Calls f with a private copy of the bucket holding contract, then publishes it. Returns f's result.
+    template <typename F>
+    auto update(name contract, F f) {
+        return update([&](auto get_bucket) { return f(get_bucket(contract)); });
+    }
+
+    void retain(const contract_abi* c, name contract, uint32_t block_num) {
+        auto& u = users[c];
+        if (u.empty())
+            total_bytes += c->bytes;
+        u.emplace_back(contract, block_num);
+    }
+
+    void release(const contract_abi* c, name contract, uint32_t block_num) {
+        auto u = users.find(c);
+        if (u == users.end())
+            return;
+        u->second.erase(std::find(u->second.begin(), u->second.end(), std::pair{contract, block_num}));
+        if (u->second.empty()) {
+            total_bytes -= c->bytes;
+            users.erase(u);
+        }
+    }
+
+    // Sets the abi contract uses from block_num on in bucket b, or removes that version if c is null. Returns
+    // whether the contract had a version at block_num before.
+    bool assign(contract_snapshot::bucket& b, name contract, uint32_t block_num, std::shared_ptr<contract_abi> c) {
+        auto& h = b[contract];
+        auto it = std::lower_bound(h.begin(), h.end(), block_num,
+                                   [](const abi_version& v, uint32_t block_num) { return v.block_num < block_num; });
+        bool existed = it != h.end() && it->block_num == block_num;
+        if (c)
+            retain(c.get(), contract, block_num);
+        if (existed) {
+            release(it->abi.get(), contract, block_num);
+            if (c)
+                it->abi = std::move(c);
+            else
+                h.erase(it);
+        } else if (c) {
+            h.insert(it, {block_num, std::move(c)});
+        }
+        if (h.empty())
+            b.erase(contract);
+        return existed;
+    }
+
+    // Replaces all of contract's versions in bucket b with c, in use from block 0 on, or removes the contract
+    // if c is null. Returns whether the contract was loaded before.
+    bool assign(contract_snapshot::bucket& b, name contract, std::shared_ptr<contract_abi> c) {
+        auto it = b.find(contract);
+        bool existed = it != b.end();
+        if (existed) {
+            for (auto& v : it->second)
+                release(v.abi.get(), contract, v.block_num);
+            b.erase(it);
+        }
+        if (c)
+            assign(b, contract, 0, std::move(c));
+        return existed;
+    }
+
+    void resize(contract_abi& c, size_t bytes) {
+        std::lock_guard<std::mutex> lock{write_mutex};
+        if (users.count(&c))
+            total_bytes += bytes - c.bytes;
+        c.bytes = bytes;
+        if (budget && total_bytes > budget)
+            over_budget.store(true, std::memory_order_relaxed);
+    }
+
+    // Like resize, by the memory c has grown
+    void grow(contract_abi& c, size_t bytes) {
+        std::lock_guard<std::mutex> lock{write_mutex};
+        if (users.count(&c))
+            total_bytes += bytes;
+        c.bytes += bytes;
+        if (budget && total_bytes > budget)
+            over_budget.store(true, std::memory_order_relaxed);
+    }
+
+    // Evicts the least recently used abis, except keep, until memory use is within the budget, then reports
+    // the evicted contracts to the eviction callback.
+    void enforce_budget(const contract_abi* keep = nullptr) {
+        std::vector<std::pair<name, uint32_t>> evicted;
+        abieos_evict_callback callback;
+        void* data;
+        {
+            std::lock_guard<std::mutex> lock{write_mutex};
+            over_budget.store(false, std::memory_order_relaxed);
+            if (!budget || total_bytes <= budget)
+                return;
+            std::vector<const contract_abi*> lru;
+            for (auto& [c, _] : users)
+                if (c != keep)
+                    lru.push_back(c);
+            std::sort(lru.begin(), lru.end(), [](auto* a, auto* b) {
+                return a->last_used.load(std::memory_order_relaxed) < b->last_used.load(std::memory_order_relaxed);
+            });
+            update_locked([&](auto get_bucket) {
+                for (auto* c : lru) {
+                    if (total_bytes <= budget)
+                        break;
+                    auto versions = users[c];
+                    for (auto [contract, block_num] : versions)
+                        assign(get_bucket(contract), contract, block_num, nullptr);
+                    evicted.insert(evicted.end(), versions.begin(), versions.end());
+                }
+                return true;
+            });
+            callback = evict_callback;
+            data = evict_data;
+        }
+        if (callback)
+            for (auto [contract, block_num] : evicted)
+                callback(data, contract.value, block_num);
+    }
+
+    // Returns the abi converted from bin, so that contracts with identical abis share one immutable type
+    // graph. Calls make to convert it if no loaded contract uses it yet.
+    template <typename F>
+    std::shared_ptr<contract_abi> share(std::string_view bin, bool lazy, F make) {
+        auto hash = eosio::murmur64(bin.data(), bin.size());
+        auto find = [&]() -> std::shared_ptr<contract_abi> {
+            auto [begin, end] = abis_by_hash.equal_range(hash);
+            for (auto it = begin; it != end; ++it)
+                if (auto c = it->second.lock(); c && c->lazy == lazy && c->source == bin)
+                    return c;
+            return nullptr;
+        };
+        {
+            std::lock_guard<std::mutex> lock{write_mutex};
+            if (auto c = find())
+                return c;
+        }
+        std::shared_ptr<contract_abi> c = make();
+        c->registry = this;
+        c->bytes = c->memory_usage();
+        std::lock_guard<std::mutex> lock{write_mutex};
+        if (auto existing = find())
+            return existing;
+        abis_by_hash.emplace(hash, c);
+        if (abis_by_hash.size() > 2 * abis_by_hash_swept + 16) {
+            for (auto it = abis_by_hash.begin(); it != abis_by_hash.end();)
+                it = it->second.expired() ? abis_by_hash.erase(it) : std::next(it);
+            abis_by_hash_swept = abis_by_hash.size();
+        }
+        return c;
+    }
+};
+
+void contract_abi::update_usage() {
+    if (registry)
+        registry->resize(*this, memory_usage());
+}
+
+void contract_abi::add_usage(const std::vector<const abi_type*>& added) {
+    if (!registry)
+        return;
+    size_t bytes = 0;
+    for (auto* t : added) {
+        if (derived.count(t->name)) {
+            // a new node of derived, keyed by the type's name
+            bytes += sizeof(std::pair<const std::string, abi_type>) + 4 * sizeof(void*) + heap_size(t->name) +
+                     heap_size(*t);
+        } else {
+            // resolved in place; its name was counted already
+            bytes += heap_size(*t) - heap_size(t->name);
+        }
+    }
+    registry->grow(*this, bytes);
+}
+
+struct abieos_registry_s {
+    std::shared_ptr<abi_registry> registry = std::make_shared<abi_registry>();
+};
+
+struct abieos_projection_s : eosio::abi_projection {
+    using abi_projection::abi_projection;
+};
+
+struct abieos_columns_s : eosio::abi_columns {
+    using abi_columns::abi_columns;
+};
+
 struct abieos_context_s {
     const char* last_error = "";
     std::string last_error_buffer{};
     std::string result_str{};
     std::vector<char> result_bin{};
+    std::vector<char> batch_data{};
+    bool lazy_abis = false;
+
+    std::shared_ptr<abi_registry> registry = std::make_shared<abi_registry>();
+    std::shared_ptr<const contract_snapshot> snapshot{};
+    uint64_t snapshot_version = 0;
+
+    // The registry's contracts as of this call. Holding the snapshot keeps its abis alive, so memory
+    // handed out by this context stays valid even if another context replaces or deletes the contract.
+    const contract_snapshot& contracts() {
+        if (registry->over_budget.load(std::memory_order_relaxed))
+            registry->enforce_budget();
+        auto version = registry->version.load(std::memory_order_acquire);
+        if (version != snapshot_version) {
+            snapshot = registry->load();
+            snapshot_version = version;
+        }
+        return *snapshot;
+    }
+
+    contract_abi& get_contract(uint64_t contract) {
+        auto* c = contracts().find(name{contract});
+        if (!c)
+            throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" is not loaded");
+        return *c;
+    }
 
-    std::map<name, abi> contracts{};
+    contract_abi& get_contract(uint64_t contract, uint32_t block_num) {
+        auto* c = contracts().find(name{contract}, block_num);
+        if (!c)
+            throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" has no abi at block " +
+                                     std::to_string(block_num));
+        return *c;
+    }
+
+    void set_contract(uint64_t contract, std::shared_ptr<contract_abi> c) {
+        auto* kept = c.get();
+        registry->update(name{contract}, [&](contract_snapshot::bucket& b) {
+            return registry->assign(b, name{contract}, std::move(c));
+        });
+        registry->enforce_budget(kept);
+    }
+
+    void set_contract(uint64_t contract, uint32_t block_num, std::shared_ptr<contract_abi> c) {
+        auto* kept = c.get();
+        registry->update(name{contract}, [&](contract_snapshot::bucket& b) {
+            return registry->assign(b, name{contract}, block_num, std::move(c));
+        });
+        registry->enforce_budget(kept);
+    }
 };
 
 void fix_null_str(const char*& s) {
@@ -52,6 +633,28 @@ extern "C" abieos_context* abieos_create() {
 
 extern "C" void abieos_destroy(abieos_context* context) { delete context; }
 
+extern "C" abieos_registry* abieos_create_registry() {
+    try {
+        return new abieos_registry{};
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+extern "C" void abieos_destroy_registry(abieos_registry* registry) { delete registry; }
+
+extern "C" abieos_context* abieos_create_with_registry(abieos_registry* registry) {
+    if (!registry)
+        return nullptr;
+    try {
+        auto* context = new abieos_context{};
+        context->registry = registry->registry;
+        return context;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
 extern "C" const char* abieos_get_error(abieos_context* context) {
     if (!context)
         return "context is null";
@@ -72,8 +675,8 @@ extern "C" const char* abieos_get_bin_data(abieos_context* context) {
 
 extern "C" const char* abieos_get_bin_hex(abieos_context* context) {
     return handle_exceptions(context, nullptr, [&] {
-        context->result_str.clear();
-        hex(context->result_bin.begin(), context->result_bin.end(), std::back_inserter(context->result_str));
+        context->result_str.resize(2 * context->result_bin.size());
+        eosio::hex_encode(context->result_bin.data(), context->result_bin.size(), context->result_str.data());
         return context->result_str.c_str();
     });
 }
@@ -90,41 +693,67 @@ extern "C" const char* abieos_name_to_string(abieos_context* context, uint64_t n
     });
 }
 
+// Converts a json abi, which is parsed in place, or returns the loaded abi identical to it
+std::shared_ptr<contract_abi> share_abi_json(abieos_context* context, char* abi) {
+    context->last_error = "abi parse error";
+    auto def = std::make_shared<abi_def>();
+    std::string error;
+    eosio::json_token_stream stream(abi);
+    from_json(*def, stream);
+    if (!check_abi_version(def->version, error))
+        throw std::runtime_error(error);
+    auto bin = convert_to_bin(*def);
+    return context->registry->share({bin.data(), bin.size()}, context->lazy_abis, [&] {
+        auto c = std::make_shared<contract_abi>();
+        c->source.assign(bin.data(), bin.size());
+        c->lazy = context->lazy_abis;
+        convert_abi(std::move(def), c->value, c->lazy);
+        return c;
+    });
+}
+
+// Converts a binary abi, or returns the loaded abi identical to it
+std::shared_ptr<contract_abi> share_abi_bin(abieos_context* context, const char* data, size_t size) {
+    context->last_error = "abi parse error";
+    if (!data || !size)
+        throw std::runtime_error("no data");
+    return context->registry->share({data, size}, context->lazy_abis, [&] {
+        auto c = std::make_shared<contract_abi>();
+        c->source.assign(data, size);
+        c->lazy = context->lazy_abis;
+        abi_from_bin({data, size}, c->value, c->lazy);
+        return c;
+    });
+}
+
 extern "C" abieos_bool abieos_set_abi(abieos_context* context, uint64_t contract, const char* abi) {
     fix_null_str(abi);
     return handle_exceptions(context, false, [&]() {
-        context->last_error = "abi parse error";
-        abi_def def{};
-        std::string error;
         std::string abi_copy{abi};
-        eosio::json_token_stream stream(abi_copy.data());
-        from_json(def, stream);
-        if (!check_abi_version(def.version, error))
-            return set_error(context, std::move(error));
-        abieos::abi c;
-        convert(def, c);
-        context->contracts.insert({name{contract}, std::move(c)});
+        context->set_contract(contract, share_abi_json(context, abi_copy.data()));
+        return true;
+    });
+}
+
+// Checks that json, which is parsed in place, is followed by the zero bytes the parser needs
+char* insitu_json(char* json, size_t size) {
+    if (!json)
+        throw std::runtime_error("json is null");
+    if (json[size] || json[size + 1] || json[size + 2])
+        throw std::runtime_error("json must be followed by 3 zero bytes");
+    return json;
+}
+
+extern "C" abieos_bool abieos_set_abi_insitu(abieos_context* context, uint64_t contract, char* abi, size_t size) {
+    return handle_exceptions(context, false, [&]() {
+        context->set_contract(contract, share_abi_json(context, insitu_json(abi, size)));
         return true;
     });
 }
 
 extern "C" abieos_bool abieos_set_abi_bin(abieos_context* context, uint64_t contract, const char* data, size_t size) {
     return handle_exceptions(context, false, [&] {
-        context->last_error = "abi parse error";
-        if (!data || !size)
-            return set_error(context, "no data");
-        std::string error;
-        eosio::input_stream stream{data, size};
-        std::string version;
-        from_bin(version, stream);
-        if (!check_abi_version(version, error))
-            return set_error(context, std::move(error));
-        abi_def def{};
-        stream = {data, size};
-        from_bin(def, stream);
-        abieos::abi c;
-        convert(def, c);
-        context->contracts.insert({name{contract}, std::move(c)});
+        context->set_contract(contract, share_abi_bin(context, data, size));
         return true;
     });
 }
@@ -134,7 +763,7 @@ extern "C" abieos_bool abieos_set_abi_hex(abieos_context* context, uint64_t cont
     return handle_exceptions(context, false, [&]() -> abieos_bool {
         std::vector<char> data;
         std::string error;
-        if (!unhex(error, hex, hex + strlen(hex), std::back_inserter(data))) {
+        if (!unhex(error, hex, data)) {
             if (!error.empty())
                 set_error(context, std::move(error));
             return false;
@@ -143,43 +772,213 @@ extern "C" abieos_bool abieos_set_abi_hex(abieos_context* context, uint64_t cont
     });
 }
 
+extern "C" abieos_bool abieos_set_abi_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                         const char* abi) {
+    fix_null_str(abi);
+    return handle_exceptions(context, false, [&]() {
+        std::string abi_copy{abi};
+        context->set_contract(contract, block_num, share_abi_json(context, abi_copy.data()));
+        return true;
+    });
+}
+
+extern "C" abieos_bool abieos_set_abi_bin_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                             const char* data, size_t size) {
+    return handle_exceptions(context, false, [&] {
+        context->set_contract(contract, block_num, share_abi_bin(context, data, size));
+        return true;
+    });
+}
+
+extern "C" void abieos_set_lazy_abis(abieos_context* context, abieos_bool lazy) {
+    if (context)
+        context->lazy_abis = lazy;
+}
+
+extern "C" abieos_bool abieos_validate_abi(abieos_context* context, uint64_t contract) {
+    return handle_exceptions(context, false, [&] {
+        context->last_error = "abi parse error";
+        context->get_contract(contract).validate();
+        return true;
+    });
+}
+
+extern "C" void abieos_set_memory_budget(abieos_context* context, size_t budget, abieos_evict_callback callback,
+                                         void* user_data) {
+    handle_exceptions(context, false, [&] {
+        auto& registry = *context->registry;
+        {
+            std::lock_guard<std::mutex> lock{registry.write_mutex};
+            registry.budget = budget;
+            registry.evict_callback = callback;
+            registry.evict_data = user_data;
+        }
+        registry.enforce_budget();
+        return true;
+    });
+}
+
+extern "C" size_t abieos_get_contract_memory(abieos_context* context, uint64_t contract) {
+    return handle_exceptions(context, size_t(0), [&] {
+        auto* c = context->contracts().peek(name{contract});
+        if (!c)
+            throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" is not loaded");
+        std::lock_guard<std::mutex> lock{context->registry->write_mutex};
+        return c->bytes;
+    });
+}
+
+extern "C" size_t abieos_get_total_memory(abieos_context* context) {
+    return handle_exceptions(context, size_t(0), [&] {
+        std::lock_guard<std::mutex> lock{context->registry->write_mutex};
+        return context->registry->total_bytes;
+    });
+}
+
+extern "C" abieos_bool abieos_write_abi_cache(abieos_context* context, const char* path,
+                                              const abieos_abi_cache_item* items, size_t count) {
+    fix_null_str(path);
+    return handle_exceptions(context, false, [&] {
+        if (count && !items)
+            return set_error(context, "abi cache items are null");
+        std::vector<const abieos_abi_cache_item*> sorted;
+        for (size_t i = 0; i < count; ++i) {
+            auto& item = items[i];
+            context->last_error = "abi parse error";
+            if (!item.data || !item.size)
+                return set_error(context, "no data for contract \"" + eosio::name_to_string(item.contract) + "\"");
+            // only cache abis which will load
+            abi scratch{};
+            abi_from_bin({item.data, item.size}, scratch, false);
+            sorted.push_back(&item);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](auto* a, auto* b) { return a->contract < b->contract; });
+        for (size_t i = 1; i < sorted.size(); ++i)
+            if (sorted[i - 1]->contract == sorted[i]->contract)
+                return set_error(context, "contract \"" + eosio::name_to_string(sorted[i]->contract) +
+                                              "\" is in the abi cache more than once");
+
+        // identical abis are stored once
+        std::vector<char> file;
+        eosio::vector_stream out{file};
+        out.write(abi_cache_magic, sizeof(abi_cache_magic));
+        out.write_raw(uint64_t(count));
+        uint64_t offset = sizeof(abi_cache_magic) + sizeof(uint64_t) + count * sizeof(abi_cache_entry);
+        std::unordered_map<std::string_view, uint64_t> offsets;
+        std::vector<std::string_view> blobs;
+        for (auto* item : sorted) {
+            auto [it, inserted] = offsets.try_emplace({item->data, item->size}, offset);
+            if (inserted) {
+                blobs.push_back(it->first);
+                offset += item->size;
+            }
+            out.write_raw(abi_cache_entry{item->contract, it->second, item->size});
+        }
+        for (auto blob : blobs)
+            out.write(blob.data(), blob.size());
+
+        // replace any existing cache atomically; processes may have it mapped
+        std::string tmp = std::string{path} + ".tmp";
+        std::ofstream f{tmp, std::ios::binary | std::ios::trunc};
+        f.write(file.data(), file.size());
+        f.close();
+        if (!f || std::rename(tmp.c_str(), path)) {
+            std::remove(tmp.c_str());
+            return set_error(context, std::string{"can't write "} + path);
+        }
+        return true;
+    });
+}
+
+extern "C" abieos_bool abieos_load_abi_cache(abieos_context* context, const char* path) {
+    fix_null_str(path);
+    return handle_exceptions(context, false, [&] {
+        auto file = std::make_shared<const mapped_file>(path);
+        eosio::input_stream stream{file->data, file->size};
+        if (stream.remaining() < sizeof(abi_cache_magic) ||
+            memcmp(stream.pos, abi_cache_magic, sizeof(abi_cache_magic)))
+            return set_error(context, std::string{path} + " is not an abi cache");
+        stream.skip(sizeof(abi_cache_magic));
+        uint64_t count;
+        from_bin(count, stream);
+        if (count > stream.remaining() / sizeof(abi_cache_entry))
+            return set_error(context, std::string{path} + " is truncated");
+        std::vector<std::pair<name, std::shared_ptr<contract_abi>>> contracts;
+        std::map<std::pair<uint64_t, uint64_t>, std::shared_ptr<contract_abi>> shared;
+        contracts.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            abi_cache_entry entry;
+            stream.read_raw(entry);
+            if (entry.offset > file->size || entry.size > file->size - entry.offset)
+                return set_error(context, std::string{path} + " is truncated");
+            // contracts whose entries point at the same abi share it
+            auto& c = shared[{entry.offset, entry.size}];
+            if (!c) {
+                c = std::make_shared<contract_abi>();
+                c->cache = file;
+                c->cached_bin = {file->data + entry.offset, entry.size};
+                c->lazy = context->lazy_abis;
+                c->registry = context->registry.get();
+                c->bytes = c->memory_usage();
+            }
+            contracts.emplace_back(name{entry.contract}, c);
+        }
+        context->registry->update([&](auto get_bucket) {
+            for (auto& [contract, c] : contracts)
+                context->registry->assign(get_bucket(contract), contract, c);
+            return true;
+        });
+        context->registry->enforce_budget();
+        return true;
+    });
+}
+
+const char* type_for_action(abi& c, uint64_t contract, uint64_t action) {
+    auto action_it = c.action_types.find(name{action});
+    if (action_it == c.action_types.end())
+        throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" does not have action \"" +
+                                 eosio::name_to_string(action) + "\"");
+    return action_it->second.c_str();
+}
+
+const char* type_for_table(abi& c, uint64_t contract, uint64_t table) {
+    auto table_it = c.table_types.find(name{table});
+    if (table_it == c.table_types.end())
+        throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" does not have table \"" +
+                                 eosio::name_to_string(table) + "\"");
+    return table_it->second.c_str();
+}
+
 extern "C" const char* abieos_get_type_for_action(abieos_context* context, uint64_t contract, uint64_t action) {
     return handle_exceptions(context, nullptr, [&] {
-        auto contract_it = context->contracts.find(::abieos::name{contract});
-        if (contract_it == context->contracts.end())
-            throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" is not loaded");
-        auto& c = contract_it->second;
+        return type_for_action(context->get_contract(contract).get_abi(), contract, action);
+    });
+}
 
-        auto action_it = c.action_types.find(name{action});
-        if (action_it == c.action_types.end())
-            throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" does not have action \"" +
-                                     eosio::name_to_string(action) + "\"");
-        return action_it->second.c_str();
+extern "C" const char* abieos_get_type_for_action_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                                     uint64_t action) {
+    return handle_exceptions(context, nullptr, [&] {
+        return type_for_action(context->get_contract(contract, block_num).get_abi(), contract, action);
     });
 }
 
 extern "C" const char* abieos_get_type_for_table(abieos_context* context, uint64_t contract, uint64_t table) {
     return handle_exceptions(context, nullptr, [&] {
-        auto contract_it = context->contracts.find(::abieos::name{contract});
-        if (contract_it == context->contracts.end())
-            throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" is not loaded");
-        auto& c = contract_it->second;
+        return type_for_table(context->get_contract(contract).get_abi(), contract, table);
+    });
+}
 
-        auto table_it = c.table_types.find(name{table});
-        if (table_it == c.table_types.end())
-            throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" does not have table \"" +
-                                     eosio::name_to_string(table) + "\"");
-        return table_it->second.c_str();
+extern "C" const char* abieos_get_type_for_table_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                                    uint64_t table) {
+    return handle_exceptions(context, nullptr, [&] {
+        return type_for_table(context->get_contract(contract, block_num).get_abi(), contract, table);
     });
 }
 
 extern "C" const char* abieos_get_type_for_action_result(abieos_context* context, uint64_t contract,
                                                          uint64_t action_result) {
     return handle_exceptions(context, nullptr, [&] {
-        auto contract_it = context->contracts.find(::abieos::name{contract});
-        if (contract_it == context->contracts.end())
-            throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" is not loaded");
-        auto& c = contract_it->second;
+        auto& c = context->get_contract(contract).get_abi();
 
         auto action_result_it = c.action_result_types.find(name{action_result});
         if (action_result_it == c.action_result_types.end())
@@ -195,28 +994,41 @@ extern "C" abieos_bool abieos_json_to_bin(abieos_context* context, uint64_t cont
     fix_null_str(json);
     return handle_exceptions(context, false, [&] {
         context->last_error = "json parse error";
-        auto contract_it = context->contracts.find(::abieos::name{contract});
-        if (contract_it == context->contracts.end())
+        auto* c = context->contracts().find(::abieos::name{contract});
+        if (!c)
             return set_error(context, "contract \"" + eosio::name_to_string(contract) + "\" is not loaded");
         std::string error;
-        auto t = contract_it->second.get_type(type);
+        auto t = c->get_type(type);
         context->result_bin.clear();
         context->result_bin = t->json_to_bin(json);
         return true;
     });
 }
 
+extern "C" abieos_bool abieos_json_to_bin_insitu(abieos_context* context, uint64_t contract, const char* type,
+                                                 char* json, size_t size) {
+    fix_null_str(type);
+    return handle_exceptions(context, false, [&] {
+        context->last_error = "json parse error";
+        auto t = context->get_contract(contract).get_type(type);
+        context->result_bin.clear();
+        eosio::vector_stream out{context->result_bin};
+        abieos::json_to_bin_insitu(out, t, insitu_json(json, size), [] {});
+        return true;
+    });
+}
+
 extern "C" abieos_bool abieos_json_to_bin_reorderable(abieos_context* context, uint64_t contract, const char* type,
                                                       const char* json) {
     fix_null_str(type);
     fix_null_str(json);
     return handle_exceptions(context, false, [&] {
         context->last_error = "json parse error";
-        auto contract_it = context->contracts.find(::abieos::name{contract});
-        if (contract_it == context->contracts.end())
+        auto* c = context->contracts().find(::abieos::name{contract});
+        if (!c)
             return set_error(context, "contract \"" + eosio::name_to_string(contract) + "\" is not loaded");
         std::string error;
-        auto t = contract_it->second.get_type(type);
+        auto t = c->get_type(type);
         context->result_bin.clear();
         context->result_bin = t->json_to_bin_reorderable(json);
         return true;
@@ -230,13 +1042,40 @@ extern "C" const char* abieos_bin_to_json(abieos_context* context, uint64_t cont
         if (!data)
             size = 0;
         context->last_error = "binary decode error";
-        auto contract_it = context->contracts.find(::abieos::name{contract});
+        auto* c = context->contracts().find(::abieos::name{contract});
         std::string error;
-        if (contract_it == context->contracts.end()) {
+        if (!c) {
             (void)set_error(error, "contract \"" + eosio::name_to_string(contract) + "\" is not loaded");
             return nullptr;
         }
-        auto t = contract_it->second.get_type(type);
+        auto t = c->get_type(type);
+        eosio::input_stream bin{data, size};
+        context->result_str = t->bin_to_json(bin);
+        return context->result_str.c_str();
+    });
+}
+
+extern "C" abieos_bool abieos_json_to_bin_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                             const char* type, const char* json) {
+    fix_null_str(type);
+    fix_null_str(json);
+    return handle_exceptions(context, false, [&] {
+        context->last_error = "json parse error";
+        auto t = context->get_contract(contract, block_num).get_type(type);
+        context->result_bin.clear();
+        context->result_bin = t->json_to_bin(json);
+        return true;
+    });
+}
+
+extern "C" const char* abieos_bin_to_json_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                             const char* type, const char* data, size_t size) {
+    fix_null_str(type);
+    return handle_exceptions(context, nullptr, [&]() -> const char* {
+        if (!data)
+            size = 0;
+        context->last_error = "binary decode error";
+        auto t = context->get_contract(contract, block_num).get_type(type);
         eosio::input_stream bin{data, size};
         context->result_str = t->bin_to_json(bin);
         return context->result_str.c_str();
@@ -249,7 +1088,7 @@ extern "C" const char* abieos_hex_to_json(abieos_context* context, uint64_t cont
     return handle_exceptions(context, nullptr, [&]() -> const char* {
         std::vector<char> data;
         std::string error;
-        if (!unhex(error, hex, hex + strlen(hex), std::back_inserter(data))) {
+        if (!unhex(error, hex, data)) {
             if (!error.empty())
                 set_error(context, std::move(error));
             return nullptr;
@@ -258,6 +1097,382 @@ extern "C" const char* abieos_hex_to_json(abieos_context* context, uint64_t cont
     });
 }
 
+const abi_type* to_abi_type(const abieos_type* type) {
+    if (!type)
+        throw std::runtime_error("type handle is null");
+    return reinterpret_cast<const abi_type*>(type);
+}
+
+extern "C" const abieos_type* abieos_resolve_type(abieos_context* context, uint64_t contract, const char* type) {
+    fix_null_str(type);
+    return handle_exceptions(context, nullptr, [&] {
+        return reinterpret_cast<const abieos_type*>(context->get_contract(contract).get_type(type));
+    });
+}
+
+extern "C" const abieos_type* abieos_resolve_type_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                                    const char* type) {
+    fix_null_str(type);
+    return handle_exceptions(context, nullptr, [&] {
+        return reinterpret_cast<const abieos_type*>(context->get_contract(contract, block_num).get_type(type));
+    });
+}
+
+extern "C" abieos_bool abieos_json_to_bin_by_handle(abieos_context* context, const abieos_type* type,
+                                                    const char* json) {
+    fix_null_str(json);
+    return handle_exceptions(context, false, [&] {
+        context->last_error = "json parse error";
+        context->result_bin.clear();
+        context->result_bin = to_abi_type(type)->json_to_bin(json);
+        return true;
+    });
+}
+
+extern "C" abieos_bool abieos_json_to_bin_by_handle_insitu(abieos_context* context, const abieos_type* type, char* json,
+                                                           size_t size) {
+    return handle_exceptions(context, false, [&] {
+        context->last_error = "json parse error";
+        context->result_bin.clear();
+        eosio::vector_stream out{context->result_bin};
+        abieos::json_to_bin_insitu(out, to_abi_type(type), insitu_json(json, size), [] {});
+        return true;
+    });
+}
+
+extern "C" abieos_bool abieos_json_to_bin_reorderable_by_handle(abieos_context* context, const abieos_type* type,
+                                                                const char* json) {
+    fix_null_str(json);
+    return handle_exceptions(context, false, [&] {
+        context->last_error = "json parse error";
+        context->result_bin.clear();
+        context->result_bin = to_abi_type(type)->json_to_bin_reorderable(json);
+        return true;
+    });
+}
+
+extern "C" const char* abieos_bin_to_json_by_handle(abieos_context* context, const abieos_type* type,
+                                                    const char* data, size_t size) {
+    return handle_exceptions(context, nullptr, [&]() -> const char* {
+        if (!data)
+            size = 0;
+        context->last_error = "binary decode error";
+        eosio::input_stream bin{data, size};
+        context->result_str = to_abi_type(type)->bin_to_json(bin);
+        return context->result_str.c_str();
+    });
+}
+
+extern "C" const char* abieos_hex_to_json_by_handle(abieos_context* context, const abieos_type* type,
+                                                    const char* hex) {
+    fix_null_str(hex);
+    return handle_exceptions(context, nullptr, [&]() -> const char* {
+        std::vector<char> data;
+        std::string error;
+        if (!unhex(error, hex, data)) {
+            if (!error.empty())
+                set_error(context, std::move(error));
+            return nullptr;
+        }
+        return abieos_bin_to_json_by_handle(context, type, data.data(), data.size());
+    });
+}
+
+extern "C" abieos_bool abieos_bin_to_msgpack(abieos_context* context, uint64_t contract, const char* type,
+                                             const char* data, size_t size) {
+    fix_null_str(type);
+    return handle_exceptions(context, false, [&] {
+        if (!data)
+            size = 0;
+        context->last_error = "binary decode error";
+        eosio::input_stream bin{data, size};
+        context->result_bin = context->get_contract(contract).get_type(type)->bin_to_msgpack(bin);
+        return true;
+    });
+}
+
+extern "C" abieos_bool abieos_bin_to_msgpack_by_handle(abieos_context* context, const abieos_type* type,
+                                                       const char* data, size_t size) {
+    return handle_exceptions(context, false, [&] {
+        if (!data)
+            size = 0;
+        context->last_error = "binary decode error";
+        eosio::input_stream bin{data, size};
+        context->result_bin = to_abi_type(type)->bin_to_msgpack(bin);
+        return true;
+    });
+}
+
+extern "C" abieos_bool abieos_bin_to_cbor(abieos_context* context, uint64_t contract, const char* type,
+                                          const char* data, size_t size) {
+    fix_null_str(type);
+    return handle_exceptions(context, false, [&] {
+        if (!data)
+            size = 0;
+        context->last_error = "binary decode error";
+        eosio::input_stream bin{data, size};
+        context->result_bin = context->get_contract(contract).get_type(type)->bin_to_cbor(bin);
+        return true;
+    });
+}
+
+extern "C" abieos_bool abieos_bin_to_cbor_by_handle(abieos_context* context, const abieos_type* type,
+                                                    const char* data, size_t size) {
+    return handle_exceptions(context, false, [&] {
+        if (!data)
+            size = 0;
+        context->last_error = "binary decode error";
+        eosio::input_stream bin{data, size};
+        context->result_bin = to_abi_type(type)->bin_to_cbor(bin);
+        return true;
+    });
+}
+
+extern "C" abieos_bool abieos_bin_size(abieos_context* context, const abieos_type* type, const char* data, size_t size,
+                                       size_t* value_size) {
+    return handle_exceptions(context, false, [&] {
+        if (!data)
+            size = 0;
+        context->last_error = "binary decode error";
+        eosio::input_stream bin{data, size};
+        to_abi_type(type)->skip(bin);
+        if (value_size)
+            *value_size = bin.pos - data;
+        return true;
+    });
+}
+
+extern "C" abieos_projection* abieos_create_projection(abieos_context* context, const abieos_type* type,
+                                                       const char* const* paths, size_t count) {
+    return handle_exceptions(context, nullptr, [&] {
+        std::vector<std::string> selected;
+        for (size_t i = 0; i < count; ++i) {
+            auto* path = paths[i];
+            fix_null_str(path);
+            selected.push_back(path);
+        }
+        return new abieos_projection{to_abi_type(type), selected};
+    });
+}
+
+extern "C" void abieos_destroy_projection(abieos_projection* projection) { delete projection; }
+
+extern "C" const char* abieos_bin_to_json_projected(abieos_context* context, const abieos_projection* projection,
+                                                    const char* data, size_t size) {
+    return handle_exceptions(context, nullptr, [&]() -> const char* {
+        if (!projection)
+            throw std::runtime_error("projection is null");
+        if (!data)
+            size = 0;
+        context->last_error = "binary decode error";
+        eosio::input_stream bin{data, size};
+        context->result_str = projection->bin_to_json(bin);
+        return context->result_str.c_str();
+    });
+}
+
+extern "C" abieos_columns* abieos_create_columns(abieos_context* context, const abieos_type* type) {
+    return handle_exceptions(context, nullptr, [&] { return new abieos_columns{to_abi_type(type)}; });
+}
+
+extern "C" void abieos_destroy_columns(abieos_columns* columns) { delete columns; }
+
+extern "C" abieos_bool abieos_append_columns(abieos_context* context, abieos_columns* columns, const char* const* rows,
+                                             const size_t* sizes, size_t count) {
+    return handle_exceptions(context, false, [&] {
+        if (!columns)
+            throw std::runtime_error("columns are null");
+        context->last_error = "binary decode error";
+        for (size_t i = 0; i < count; ++i) {
+            eosio::input_stream bin{rows[i], rows[i] ? sizes[i] : 0};
+            columns->append(bin);
+        }
+        return true;
+    });
+}
+
+extern "C" void abieos_clear_columns(abieos_columns* columns) {
+    if (columns)
+        columns->clear();
+}
+
+extern "C" uint64_t abieos_get_row_count(const abieos_columns* columns) { return columns ? columns->rows : 0; }
+
+extern "C" size_t abieos_get_column_count(const abieos_columns* columns) {
+    return columns ? columns->columns.size() : 0;
+}
+
+extern "C" abieos_bool abieos_get_column(abieos_context* context, const abieos_columns* columns, size_t index,
+                                         abieos_column* column) {
+    return handle_exceptions(context, false, [&] {
+        if (!columns || index >= columns->columns.size())
+            throw std::runtime_error("column index out of range");
+        auto& c = columns->columns[index];
+        *column = {};
+        column->name = c.name.c_str();
+        column->kind = c.kind;
+        column->width = c.width;
+        column->parent = c.parent == eosio::abi_columns::npos ? -1 : int64_t(c.parent);
+        column->nullable = c.nullable;
+        column->size = c.size();
+        column->data = c.data.data();
+        column->data_size = c.data.size();
+        column->offsets = c.kind == eosio::abi_columns::column::fixed ? nullptr : c.offsets.data();
+        column->validity = c.nullable ? c.validity.data() : nullptr;
+        return true;
+    });
+}
+
+// Runs write(stream) with a stream over the caller's buffer. Fails if the output doesn't fit; *needed then holds the
+// size it requires.
+template <typename F>
+abieos_bool write_into(abieos_context* context, char* out, size_t capacity, size_t* needed, F write) {
+    return handle_exceptions(context, false, [&] {
+        if (needed)
+            *needed = 0;
+        if (!out)
+            capacity = 0;
+        eosio::bounded_buf_stream stream{out, capacity};
+        write(stream);
+        if (needed)
+            *needed = stream.size;
+        if (stream.size > capacity)
+            return set_error(context, "output buffer is too small");
+        return true;
+    });
+}
+
+const abi_type* get_contract_type(abieos_context* context, uint64_t contract, const char* type) {
+    auto* c = context->contracts().find(::abieos::name{contract});
+    if (!c)
+        throw std::runtime_error("contract \"" + eosio::name_to_string(contract) + "\" is not loaded");
+    return c->get_type(type);
+}
+
+extern "C" abieos_bool abieos_json_to_bin_into(abieos_context* context, uint64_t contract, const char* type,
+                                               const char* json, char* out, size_t capacity, size_t* needed) {
+    fix_null_str(type);
+    fix_null_str(json);
+    return write_into(context, out, capacity, needed, [&](auto& stream) {
+        context->last_error = "json parse error";
+        abieos::json_to_bin(stream, get_contract_type(context, contract, type), json, [] {});
+    });
+}
+
+extern "C" abieos_bool abieos_json_to_bin_by_handle_into(abieos_context* context, const abieos_type* type,
+                                                         const char* json, char* out, size_t capacity,
+                                                         size_t* needed) {
+    fix_null_str(json);
+    return write_into(context, out, capacity, needed, [&](auto& stream) {
+        context->last_error = "json parse error";
+        abieos::json_to_bin(stream, to_abi_type(type), json, [] {});
+    });
+}
+
+extern "C" abieos_bool abieos_bin_to_json_into(abieos_context* context, uint64_t contract, const char* type,
+                                               const char* data, size_t size, char* out, size_t capacity,
+                                               size_t* needed) {
+    fix_null_str(type);
+    if (!data)
+        size = 0;
+    return write_into(context, out, capacity, needed, [&](auto& stream) {
+        context->last_error = "binary decode error";
+        eosio::input_stream bin{data, size};
+        abieos::bin_to_json(bin, get_contract_type(context, contract, type), stream, [] {});
+    });
+}
+
+extern "C" abieos_bool abieos_bin_to_json_by_handle_into(abieos_context* context, const abieos_type* type,
+                                                         const char* data, size_t size, char* out,
+                                                         size_t capacity, size_t* needed) {
+    if (!data)
+        size = 0;
+    return write_into(context, out, capacity, needed, [&](auto& stream) {
+        context->last_error = "binary decode error";
+        eosio::input_stream bin{data, size};
+        abieos::bin_to_json(bin, to_abi_type(type), stream, [] {});
+    });
+}
+
+// Runs convert(type, item, context->batch_data) for each item. Each item's output, or its error message if it failed,
+// is appended to batch_data followed by a 0 byte which isn't included in the result's size.
+template <typename F>
+abieos_bool convert_batch(abieos_context* context, const abieos_batch_item* items, size_t count,
+                          abieos_batch_result* results, F convert) {
+    return handle_exceptions(context, false, [&] {
+        if (count && (!items || !results))
+            return set_error(context, "batch items or results are null");
+        auto& arena = context->batch_data;
+        arena.clear();
+        // one snapshot for the whole batch keeps looked up types alive
+        auto& contracts = context->contracts();
+        bool ok = true;
+        const abieos_batch_item* named = nullptr;
+        const abi_type* named_type = nullptr;
+        for (size_t i = 0; i < count; ++i) {
+            auto& item = items[i];
+            auto& result = results[i];
+            result.offset = arena.size();
+            try {
+                const abi_type* type;
+                if (item.type) {
+                    type = to_abi_type(item.type);
+                } else {
+                    const char* type_name = item.type_name;
+                    fix_null_str(type_name);
+                    // consecutive items usually share a type; only look it up again when it changes
+                    if (!named || named->contract != item.contract || strcmp(named->type_name, type_name)) {
+                        named = nullptr;
+                        auto* c = contracts.find(name{item.contract});
+                        if (!c)
+                            throw std::runtime_error("contract \"" + eosio::name_to_string(item.contract) +
+                                                     "\" is not loaded");
+                        named_type = c->get_type(type_name);
+                        named = &item;
+                    }
+                    type = named_type;
+                }
+                convert(type, item, arena);
+                result.ok = true;
+            } catch (std::exception& e) {
+                arena.resize(result.offset);
+                arena.insert(arena.end(), e.what(), e.what() + strlen(e.what()));
+                if (ok)
+                    set_error(context, e.what());
+                ok = false;
+                result.ok = false;
+            }
+            result.size = arena.size() - result.offset;
+            arena.push_back(0);
+        }
+        return ok;
+    });
+}
+
+extern "C" abieos_bool abieos_bin_to_json_batch(abieos_context* context, const abieos_batch_item* items, size_t count,
+                                                abieos_batch_result* results) {
+    return convert_batch(context, items, count, results,
+                         [](const abi_type* type, const abieos_batch_item& item, std::vector<char>& arena) {
+                             eosio::input_stream bin{item.data, item.data ? item.size : 0};
+                             eosio::vector_stream writer{arena};
+                             abieos::bin_to_json(bin, type, writer, [] {});
+                         });
+}
+
+extern "C" abieos_bool abieos_json_to_bin_batch(abieos_context* context, const abieos_batch_item* items, size_t count,
+                                                abieos_batch_result* results) {
+    return convert_batch(context, items, count, results,
+                         [](const abi_type* type, const abieos_batch_item& item, std::vector<char>& arena) {
+                             abieos::json_to_bin(arena, type, item.data ? item.data : "", [] {});
+                         });
+}
+
+extern "C" const char* abieos_get_batch_data(abieos_context* context) {
+    if (!context)
+        return nullptr;
+    return context->batch_data.data();
+}
+
 extern "C" abieos_bool abieos_abi_json_to_bin(abieos_context* context, const char* abi_json) {
     fix_null_str(abi_json);
     return handle_exceptions(context, false, [&] {
@@ -299,11 +1514,9 @@ extern "C" const char* abieos_abi_bin_to_json(abieos_context* context, const cha
 }
 
 extern "C" abieos_bool abieos_delete_contract(abieos_context* context, uint64_t contract) {
-    auto itr = context->contracts.find(::abieos::name{contract});
-    if(itr == context->contracts.end()) {
-        return false;
-    } else {
-        context->contracts.erase(itr);
-        return true;
-    }
+    return handle_exceptions(context, false, [&] {
+        return context->registry->update(name{contract}, [&](contract_snapshot::bucket& b) {
+            return context->registry->assign(b, name{contract}, nullptr);
+        });
+    });
 }
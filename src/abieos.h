@@ -10,6 +10,10 @@ extern "C" {
 #endif
 
 typedef struct abieos_context_s abieos_context;
+typedef struct abieos_registry_s abieos_registry;
+typedef struct abieos_type_s abieos_type;
+typedef struct abieos_projection_s abieos_projection;
+typedef struct abieos_columns_s abieos_columns;
 typedef int abieos_bool;
 
 // Create a context. The context holds all memory allocated by functions in this header. Returns null on failure.
@@ -18,6 +22,18 @@ abieos_context* abieos_create();
 // Destroy a context.
 void abieos_destroy(abieos_context* context);
 
+// Create a registry of abis which can be shared by several contexts. Returns null on failure.
+abieos_registry* abieos_create_registry();
+
+// Destroy a registry. Contexts created with it keep working; the abis are freed with the last of them.
+void abieos_destroy_registry(abieos_registry* registry);
+
+// Create a context which loads abis into, and reads them from, registry instead of holding its own. Contexts sharing
+// a registry may be used concurrently by different threads, each context by one thread at a time. Conversions never
+// wait for abieos_set_abi* or abieos_delete_contract on other contexts; they see those changes from their next call
+// on. Returns null on failure.
+abieos_context* abieos_create_with_registry(abieos_registry* registry);
+
 // Get last error. Never returns null. The context owns the returned string.
 const char* abieos_get_error(abieos_context* context);
 
@@ -35,15 +51,80 @@ const char* abieos_get_bin_hex(abieos_context* context);
 uint64_t abieos_string_to_name(abieos_context* context, const char* str);
 const char* abieos_name_to_string(abieos_context* context, uint64_t name);
 
-// Set abi (JSON format). Returns false on error.
+// Set abi (JSON format). Replaces any abis previously set for the contract, including every version set with
+// abieos_set_abi_at; the new abi is in effect from block 0 on. Contracts whose abis are identical share
+// one converted copy, whichever abieos_set_abi* call set them. Returns false on error.
 abieos_bool abieos_set_abi(abieos_context* context, uint64_t contract, const char* abi);
 
-// Set abi (binary format). Returns false on error.
+// Same as abieos_set_abi, without copying the json: abi holds size bytes of json followed by at least 3 zero bytes,
+// and is overwritten while it is parsed.
+abieos_bool abieos_set_abi_insitu(abieos_context* context, uint64_t contract, char* abi, size_t size);
+
+// Set abi (binary format). Like abieos_set_abi, replaces every version previously set for the contract; the new abi
+// is in effect from block 0 on. Returns false on error.
 abieos_bool abieos_set_abi_bin(abieos_context* context, uint64_t contract, const char* data, size_t size);
 
-// Set abi (hex format). Returns false on error.
+// Set abi (hex format). Like abieos_set_abi, replaces every version previously set for the contract; the new abi is
+// in effect from block 0 on. Returns false on error.
 abieos_bool abieos_set_abi_hex(abieos_context* context, uint64_t contract, const char* hex);
 
+// Set the abi (JSON format) a contract uses from block block_num on, until the block of its next version. Other
+// versions of the contract's abi are kept, so conversions at any block use the abi in effect then, while calls which
+// don't take a block use the latest version. Replaces a version previously set at the same block. Returns false on
+// error.
+abieos_bool abieos_set_abi_at(abieos_context* context, uint64_t contract, uint32_t block_num, const char* abi);
+
+// Same as abieos_set_abi_at, with a binary abi.
+abieos_bool abieos_set_abi_bin_at(abieos_context* context, uint64_t contract, uint32_t block_num, const char* data,
+                                  size_t size);
+
+// Choose whether abis set through this context from now on are resolved lazily: each type, with the types it
+// depends on, is resolved when it is first used, instead of every type when the abi is set. This makes setting
+// abis much cheaper when only a few of their types are used, but errors in a type are only reported once it is
+// used, or by abieos_validate_abi. Off by default.
+void abieos_set_lazy_abis(abieos_context* context, abieos_bool lazy);
+
+// Resolve every type of a contract's abi, reporting the first error. Only needed for lazily resolved abis; other abis
+// are fully checked when set. Returns false on error.
+abieos_bool abieos_validate_abi(abieos_context* context, uint64_t contract);
+
+// Called with each contract abi version evicted to stay within a memory budget. block_num is the block the version took
+// effect at; 0 for abis set without one.
+typedef void (*abieos_evict_callback)(void* user_data, uint64_t contract, uint32_t block_num);
+
+// Limit the memory used by the abis of this context's registry, which contexts created with the same registry share, to
+// about budget bytes; 0 removes the limit. When the budget is exceeded, the least recently used abis are removed from
+// every contract version using them, and callback (if not null) receives each evicted version so the host can reload
+// it when it is needed again. Eviction runs after abieos_set_abi* and abieos_load_abi_cache, and, when abis have grown from
+// conversion on first use or lazy resolution, at the start of the next conversion. The callback runs on the thread
+// which triggered the eviction.
+void abieos_set_memory_budget(abieos_context* context, size_t budget, abieos_evict_callback callback, void* user_data);
+
+// Get the approximate memory used by a contract's latest abi, in bytes. Contracts sharing an identical abi each report its
+// full size. Returns 0 on error.
+size_t abieos_get_contract_memory(abieos_context* context, uint64_t contract);
+
+// Get the approximate memory used by all abis of this context's registry, in bytes. Shared abis count once.
+size_t abieos_get_total_memory(abieos_context* context);
+
+// A contract's binary abi, for abieos_write_abi_cache.
+typedef struct abieos_abi_cache_item_s {
+    uint64_t contract;
+    const char* data;
+    size_t size;
+} abieos_abi_cache_item;
+
+// Write count binary abis to an abi cache file at path, replacing it atomically. Each abi is checked the way
+// abieos_set_abi_bin would check it. Identical abis are stored once and shared by their contracts when loaded.
+// Returns false on error.
+abieos_bool abieos_write_abi_cache(abieos_context* context, const char* path, const abieos_abi_cache_item* items,
+                                   size_t count);
+
+// Set the abis in an abi cache file. The file is mapped rather than parsed: loading only indexes its contracts, and
+// processes loading the same file share its memory. Each abi is parsed on first use, so errors from a damaged abi are
+// reported then. Replaces any abis previously set for those contracts. Returns false on error.
+abieos_bool abieos_load_abi_cache(abieos_context* context, const char* path);
+
 // Get the type name for an action. The context owns the returned memory. Returns null on error; use abieos_get_error
 // to retrieve error.
 const char* abieos_get_type_for_action(abieos_context* context, uint64_t contract, uint64_t action);
@@ -52,6 +133,14 @@ const char* abieos_get_type_for_action(abieos_context* context, uint64_t contrac
 // to retrieve error.
 const char* abieos_get_type_for_table(abieos_context* context, uint64_t contract, uint64_t table);
 
+// Same as abieos_get_type_for_action, using the abi the contract had at block_num.
+const char* abieos_get_type_for_action_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                          uint64_t action);
+
+// Same as abieos_get_type_for_table, using the abi the contract had at block_num.
+const char* abieos_get_type_for_table_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                         uint64_t table);
+
 // Get the type name for an action_result. The context owns the returned memory. Returns null on error; use
 // abieos_get_error to retrieve error.
 const char* abieos_get_type_for_action_result(abieos_context* context, uint64_t contract, uint64_t action_result);
@@ -59,6 +148,11 @@ const char* abieos_get_type_for_action_result(abieos_context* context, uint64_t
 // Convert json to binary. Use abieos_get_bin_* to retrieve result. Returns false on error.
 abieos_bool abieos_json_to_bin(abieos_context* context, uint64_t contract, const char* type, const char* json);
 
+// Same as abieos_json_to_bin, without copying the json: json holds size bytes of json followed by at least 3 zero
+// bytes, and is overwritten while it is parsed. Suited to buffers the caller discards after converting them.
+abieos_bool abieos_json_to_bin_insitu(abieos_context* context, uint64_t contract, const char* type, char* json,
+                                      size_t size);
+
 // Convert json to binary. Allow json field reordering. Use abieos_get_bin_* to retrieve result. Returns false on error.
 abieos_bool abieos_json_to_bin_reorderable(abieos_context* context, uint64_t contract, const char* type,
                                            const char* json);
@@ -72,6 +166,174 @@ const char* abieos_bin_to_json(abieos_context* context, uint64_t contract, const
 // error.
 const char* abieos_hex_to_json(abieos_context* context, uint64_t contract, const char* type, const char* hex);
 
+// Same as abieos_json_to_bin, using the abi the contract had at block_num.
+abieos_bool abieos_json_to_bin_at(abieos_context* context, uint64_t contract, uint32_t block_num, const char* type,
+                                  const char* json);
+
+// Same as abieos_bin_to_json, using the abi the contract had at block_num.
+const char* abieos_bin_to_json_at(abieos_context* context, uint64_t contract, uint32_t block_num, const char* type,
+                                  const char* data, size_t size);
+
+// Resolve a contract's type once so repeated conversions can skip the contract and type lookups. The handle stays valid
+// until the contract is deleted, replaced or evicted. Returns null on error; use abieos_get_error to retrieve error.
+const abieos_type* abieos_resolve_type(abieos_context* context, uint64_t contract, const char* type);
+
+// Same as abieos_resolve_type, using the abi the contract had at block_num.
+const abieos_type* abieos_resolve_type_at(abieos_context* context, uint64_t contract, uint32_t block_num,
+                                          const char* type);
+
+// Same as abieos_json_to_bin, using a type handle from abieos_resolve_type.
+abieos_bool abieos_json_to_bin_by_handle(abieos_context* context, const abieos_type* type, const char* json);
+
+// Same as abieos_json_to_bin_insitu, using a type handle from abieos_resolve_type.
+abieos_bool abieos_json_to_bin_by_handle_insitu(abieos_context* context, const abieos_type* type, char* json,
+                                                size_t size);
+
+// Same as abieos_json_to_bin_reorderable, using a type handle from abieos_resolve_type.
+abieos_bool abieos_json_to_bin_reorderable_by_handle(abieos_context* context, const abieos_type* type,
+                                                     const char* json);
+
+// Same as abieos_bin_to_json, using a type handle from abieos_resolve_type.
+const char* abieos_bin_to_json_by_handle(abieos_context* context, const abieos_type* type, const char* data,
+                                         size_t size);
+
+// Same as abieos_hex_to_json, using a type handle from abieos_resolve_type.
+const char* abieos_hex_to_json_by_handle(abieos_context* context, const abieos_type* type, const char* hex);
+
+// Convert binary to MessagePack, with the structure of the json abieos_bin_to_json returns. Use abieos_get_bin_* to
+// retrieve result. Returns false on error.
+abieos_bool abieos_bin_to_msgpack(abieos_context* context, uint64_t contract, const char* type, const char* data,
+                                  size_t size);
+
+// Same as abieos_bin_to_msgpack, using a type handle from abieos_resolve_type.
+abieos_bool abieos_bin_to_msgpack_by_handle(abieos_context* context, const abieos_type* type, const char* data,
+                                            size_t size);
+
+// Convert binary to CBOR. Otherwise the same as abieos_bin_to_msgpack.
+abieos_bool abieos_bin_to_cbor(abieos_context* context, uint64_t contract, const char* type, const char* data,
+                               size_t size);
+
+// Same as abieos_bin_to_cbor, using a type handle from abieos_resolve_type.
+abieos_bool abieos_bin_to_cbor_by_handle(abieos_context* context, const abieos_type* type, const char* data,
+                                         size_t size);
+
+// Get the size of the binary value of type at the start of data (size bytes) without converting it. Use it to step
+// over values or to find the ones which follow. Returns false on error.
+abieos_bool abieos_bin_size(abieos_context* context, const abieos_type* type, const char* data, size_t size,
+                            size_t* value_size);
+
+// Select count field paths of a type handle from abieos_resolve_type for abieos_bin_to_json_projected. A path names
+// fields separated by '.', with "[]" after an array's name to continue into its elements, e.g.
+// "action_traces[].act.name". The projection stays valid as long as the type handle. Returns null on error; use
+// abieos_get_error to retrieve error.
+abieos_projection* abieos_create_projection(abieos_context* context, const abieos_type* type, const char* const* paths,
+                                            size_t count);
+
+// Destroy a projection.
+void abieos_destroy_projection(abieos_projection* projection);
+
+// Convert binary to json holding only the fields selected by projection. The binary of the other fields is skipped
+// without being converted. The context owns the returned string. Returns null on error; use abieos_get_error to
+// retrieve error.
+const char* abieos_bin_to_json_projected(abieos_context* context, const abieos_projection* projection,
+                                         const char* data, size_t size);
+
+// Convert json to binary, writing it to out instead of a buffer owned by the context. *needed (if not null) receives
+// the binary's size. Returns false on error, including when the binary doesn't fit in capacity bytes; *needed is then
+// nonzero, so the caller can retry with a large enough buffer. out may be null to only query the size. The binary is
+// still encoded into an internal buffer first, since array sizes are only known once each array ends, then copied to
+// out.
+abieos_bool abieos_json_to_bin_into(abieos_context* context, uint64_t contract, const char* type, const char* json,
+                                    char* out, size_t capacity, size_t* needed);
+
+// Same as abieos_json_to_bin_into, using a type handle from abieos_resolve_type.
+abieos_bool abieos_json_to_bin_by_handle_into(abieos_context* context, const abieos_type* type, const char* json,
+                                              char* out, size_t capacity, size_t* needed);
+
+// Convert binary to json, writing it to out. The json is not null-terminated. Otherwise the same as
+// abieos_json_to_bin_into.
+abieos_bool abieos_bin_to_json_into(abieos_context* context, uint64_t contract, const char* type, const char* data,
+                                    size_t size, char* out, size_t capacity, size_t* needed);
+
+// Same as abieos_bin_to_json_into, using a type handle from abieos_resolve_type.
+abieos_bool abieos_bin_to_json_by_handle_into(abieos_context* context, const abieos_type* type, const char* data,
+                                              size_t size, char* out, size_t capacity, size_t* needed);
+
+// An input to a batch conversion. The type is either a handle from abieos_resolve_type, or, if type is null, looked up
+// from contract and type_name. data is the binary (size bytes) for bin_to_json, or null-terminated json for json_to_bin.
+typedef struct abieos_batch_item_s {
+    uint64_t contract;
+    const char* type_name;
+    const abieos_type* type;
+    const char* data;
+    size_t size;
+} abieos_batch_item;
+
+// Where a batch item's output is in abieos_get_batch_data. If ok is false, the location holds the item's error message
+// instead. Each output is followed by a 0 byte which isn't included in size, so json and messages are C strings.
+typedef struct abieos_batch_result_s {
+    size_t offset;
+    size_t size;
+    abieos_bool ok;
+} abieos_batch_result;
+
+// Convert count binary values to json. All outputs are written into one buffer owned by the context; results (an array
+// of count entries) receives each item's location and status. Returns false if any item failed; abieos_get_error
+// then holds the first failure. Results remain valid until the next batch call.
+abieos_bool abieos_bin_to_json_batch(abieos_context* context, const abieos_batch_item* items, size_t count,
+                                     abieos_batch_result* results);
+
+// Convert count json values to binary. Otherwise the same as abieos_bin_to_json_batch.
+abieos_bool abieos_json_to_bin_batch(abieos_context* context, const abieos_batch_item* items, size_t count,
+                                     abieos_batch_result* results);
+
+// Get the output buffer of the last batch conversion. The context owns the returned memory.
+const char* abieos_get_batch_data(abieos_context* context);
+
+// Create columns for rows of a type handle from abieos_resolve_type. Each builtin the type holds gets a column, named by
+// its path, such as "authorization[].actor". The columns stay valid as long as the type handle. Returns null on error;
+// use abieos_get_error to retrieve error.
+abieos_columns* abieos_create_columns(abieos_context* context, const abieos_type* type);
+
+// Destroy columns.
+void abieos_destroy_columns(abieos_columns* columns);
+
+// Decode count binary rows (rows[i] holds sizes[i] bytes) into columns. Returns false on error; the rows before the one
+// which failed are kept.
+abieos_bool abieos_append_columns(abieos_context* context, abieos_columns* columns, const char* const* rows,
+                                  const size_t* sizes, size_t count);
+
+// Remove the rows from columns, keeping the columns themselves.
+void abieos_clear_columns(abieos_columns* columns);
+
+// Get the number of rows in columns.
+uint64_t abieos_get_row_count(const abieos_columns* columns);
+
+// Get the number of columns.
+size_t abieos_get_column_count(const abieos_columns* columns);
+
+// A column's values. kind is 0 for fixed-size values, width bytes each in data, stored as in binary; 1 for values of
+// varying size, the ith from data + offsets[i] to data + offsets[i + 1]; and 2 for lists of the values of the columns
+// whose parent is this column, the ith list holding the values from offsets[i] to offsets[i + 1]. parent is the list
+// column whose lists hold the values, or -1 if there is one value per row. If nullable, validity[i] is 0 for each null
+// value. The memory belongs to columns and is valid until they next change.
+typedef struct abieos_column_s {
+    const char* name;
+    int kind;
+    uint32_t width;
+    int64_t parent;
+    abieos_bool nullable;
+    uint64_t size;
+    const char* data;
+    size_t data_size;
+    const uint64_t* offsets;
+    const uint8_t* validity;
+} abieos_column;
+
+// Get column index of columns. Returns false on error.
+abieos_bool abieos_get_column(abieos_context* context, const abieos_columns* columns, size_t index,
+                              abieos_column* column);
+
 // Convert abi json to bin, Use abieos_get_bin_* to retrieve result. Returns false on error.
 abieos_bool abieos_abi_json_to_bin(abieos_context* context, const char* json);
 
@@ -7,7 +7,9 @@
 #include <eosio/from_json.hpp>
 #include <eosio/reflection.hpp>
 #include <eosio/to_bin.hpp>
+#include <eosio/to_cbor.hpp>
 #include <eosio/to_json.hpp>
+#include <eosio/to_msgpack.hpp>
 #include <eosio/abi.hpp>
 #include <eosio/operators.hpp>
 #include <eosio/bytes.hpp>
@@ -47,12 +49,7 @@ namespace abieos {
 using eosio::from_bin;
 using eosio::to_bin;
 
-inline constexpr bool trace_json_to_jvalue_event = false;
-inline constexpr bool trace_json_to_jvalue = false;
 inline constexpr bool trace_jvalue_to_bin = false;
-inline constexpr bool trace_json_to_bin = false;
-inline constexpr bool trace_json_to_bin_event = false;
-inline constexpr bool trace_bin_to_json = false;
 
 inline constexpr size_t max_stack_size = 128;
 
@@ -69,16 +66,14 @@ struct pseudo_variant;
 template <typename SrcIt, typename DestIt>
 void hex(SrcIt begin, SrcIt end, DestIt dest) {
     static_assert(sizeof(*begin) == 1, "SrcIt should be an iterator to a byte");
-    auto nibble = [&dest](uint8_t i) {
-        if (i <= 9)
-            *dest++ = '0' + i;
-        else
-            *dest++ = 'A' + i - 10;
-    };
+    char in[256];
+    char out[2 * sizeof(in)];
     while (begin != end) {
-        nibble(((uint8_t)*begin) >> 4);
-        nibble(((uint8_t)*begin) & 0xf);
-        ++begin;
+        size_t n = 0;
+        for (; begin != end && n < sizeof(in); ++begin)
+            in[n++] = *begin;
+        eosio::hex_encode(in, n, out);
+        dest = std::copy(out, out + 2 * n, dest);
     }
 }
 
@@ -90,6 +85,14 @@ std::string hex(SrcIt begin, SrcIt end) {
     return s;
 }
 
+// Decodes hex into dest, which it resizes
+ABIEOS_NODISCARD inline bool unhex(std::string& error, std::string_view hex, std::vector<char>& dest) {
+    dest.resize(hex.size() / 2);
+    if (!eosio::hex_decode(hex.data(), hex.size(), dest.data()))
+        return set_error(error, "expected hex string");
+    return true;
+}
+
 // !!!
 template <typename SrcIt, typename DestIt>
 ABIEOS_NODISCARD bool unhex(std::string& error, SrcIt begin, SrcIt end, DestIt dest) {
@@ -114,83 +117,44 @@ ABIEOS_NODISCARD bool unhex(std::string& error, SrcIt begin, SrcIt end, DestIt d
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// stream events
+// json model
 ///////////////////////////////////////////////////////////////////////////////
 
-enum class event_type {
-    received_null,         // 0
-    received_bool,         // 1
-    received_string,       // 2
-    received_start_object, // 3
-    received_key,          // 4
-    received_end_object,   // 5
-    received_start_array,  // 6
-    received_end_array,    // 7
-};
-
-struct event_data {
-    bool value_bool = 0;
-    std::string value_string{};
-    std::string key{};
-};
-
-template <typename Derived>
-struct json_reader_handler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Derived> {
-    event_data received_data{};
-    bool started = false;
-
-    Derived& get_derived() { return *static_cast<Derived*>(this); }
-
-    bool get_start() {
-        if (started)
-            return false;
-        started = true;
-        return true;
-    }
-
-    bool get_bool() const { return received_data.value_bool; }
+// A json value in a json_arena. Strings and keys point into the json it was parsed from, which must outlive it;
+// the members of an object and the elements of an array are stored contiguously.
+struct jvalue {
+    enum class kind : uint8_t { null, boolean, string, object, array };
 
-    const std::string& get_string() const { return received_data.value_string; }
+    kind type = kind::null;
+    bool value_bool = false;
+    uint32_t size = 0;
+    std::string_view key{};
+    std::string_view value_string{};
+    const jvalue* children = nullptr;
 
-    bool Null() { return receive_event(get_derived(), event_type::received_null, get_start()); }
-    bool Bool(bool v) {
-        received_data.value_bool = v;
-        return receive_event(get_derived(), event_type::received_bool, get_start());
-    }
-    bool RawNumber(const char* v, rapidjson::SizeType length, bool copy) { return String(v, length, copy); }
-    bool Int(int v) { return false; }
-    bool Uint(unsigned v) { return false; }
-    bool Int64(int64_t v) { return false; }
-    bool Uint64(uint64_t v) { return false; }
-    bool Double(double v) { return false; }
-    bool String(const char* v, rapidjson::SizeType length, bool) {
-        received_data.value_string = {v, length};
-        return receive_event(get_derived(), event_type::received_string, get_start());
-    }
-    bool StartObject() { return receive_event(get_derived(), event_type::received_start_object, get_start()); }
-    bool Key(const char* v, rapidjson::SizeType length, bool) {
-        received_data.key = {v, length};
-        return receive_event(get_derived(), event_type::received_key, get_start());
-    }
-    bool EndObject(rapidjson::SizeType) {
-        return receive_event(get_derived(), event_type::received_end_object, get_start());
-    }
-    bool StartArray() { return receive_event(get_derived(), event_type::received_start_array, get_start()); }
-    bool EndArray(rapidjson::SizeType) {
-        return receive_event(get_derived(), event_type::received_end_array, get_start());
-    }
+    const jvalue* begin() const { return children; }
+    const jvalue* end() const { return children + size; }
 };
 
-///////////////////////////////////////////////////////////////////////////////
-// json model
-///////////////////////////////////////////////////////////////////////////////
-
-struct jvalue;
-using jarray = std::vector<jvalue>;
-using jobject = std::map<std::string, jvalue>;
-
-struct jvalue {
-    std::variant<std::nullptr_t, bool, std::string, jobject, jarray> value;
+// Bump allocator for the jvalues of one document. Everything is freed at once with the arena.
+class json_arena {
+    std::vector<std::unique_ptr<jvalue[]>> blocks;
+    size_t used = 0;
+    size_t capacity = 0;
+
+  public:
+    jvalue* allocate(size_t n) {
+        if (!n)
+            return nullptr;
+        if (capacity - used < n) {
+            capacity = std::max(n, std::max(capacity * 2, size_t(64)));
+            blocks.push_back(std::make_unique<jvalue[]>(capacity));
+            used = 0;
+        }
+        auto* result = blocks.back().get() + used;
+        used += n;
+        return result;
+    }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -199,92 +163,177 @@ struct jvalue {
 
 using eosio::abi_type;
 
-struct size_insertion {
-    size_t position = 0;
-    uint32_t size = 0;
-};
+// Writes the key of field, "name":, which was escaped when the abi was loaded
+template <typename Writer>
+void write_key(const eosio::abi_field& field, Writer& writer) {
+    writer.write(field.json_key.data(), field.json_key.size());
+}
 
-struct json_to_jvalue_stack_entry {
-    jvalue* value = nullptr;
-    std::string key = "";
-};
+// Writes the name of a variant alternative: its key without the colon
+template <typename Writer>
+void write_alternative(const eosio::abi_field& alternative, Writer& writer) {
+    writer.write(alternative.json_key.data(), alternative.json_key.size() - 1);
+}
 
 struct jvalue_to_bin_stack_entry {
     const abi_type* type = nullptr;
     bool allow_extensions = false;
     const jvalue* value = nullptr;
     int position = -1;
+    size_t field_values = 0;
 };
 
-struct json_to_bin_stack_entry {
-    const abi_type* type = nullptr;
-    bool allow_extensions = false;
-    int position = -1;
-    size_t size_insertion_index = 0;
-    size_t variant_type_index = 0;
-};
+// Builds jvalues from parser events. Members and elements of the open objects and arrays collect in pending,
+// and move to the arena as one block once their object or array ends.
+struct json_to_jvalue_state : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, json_to_jvalue_state> {
+    json_arena& arena;
+    std::vector<jvalue> pending{};
+    std::vector<size_t> open{};
+    std::string_view key{};
+    std::string error{};
+
+    explicit json_to_jvalue_state(json_arena& arena) : arena{arena} {}
+
+    bool add(jvalue value) {
+        if (open.empty() && !pending.empty())
+            return set_error(*this, "extra data");
+        value.key = key;
+        key = {};
+        pending.push_back(value);
+        return true;
+    }
 
-struct bin_to_json_stack_entry {
-    const abi_type* type = nullptr;
-    bool allow_extensions = false;
-    int position = -1;
-    uint32_t array_size = 0;
-};
+    bool start(jvalue::kind type) {
+        if (open.size() >= max_stack_size)
+            return set_error(*this, "recursion limit reached");
+        if (!add({type}))
+            return false;
+        open.push_back(pending.size() - 1);
+        return true;
+    }
 
-struct json_to_jvalue_state : json_reader_handler<json_to_jvalue_state> {
-    std::string& error;
-    std::vector<json_to_jvalue_stack_entry> stack;
+    bool end() {
+        auto index = open.back();
+        open.pop_back();
+        auto& v = pending[index];
+        v.size = pending.size() - index - 1;
+        auto* children = arena.allocate(v.size);
+        std::copy(pending.begin() + index + 1, pending.end(), children);
+        v.children = children;
+        pending.resize(index + 1);
+        return true;
+    }
 
-    json_to_jvalue_state(std::string& error) : error{error} {}
+    bool Null() { return add({jvalue::kind::null}); }
+    bool Bool(bool b) {
+        jvalue v{jvalue::kind::boolean};
+        v.value_bool = b;
+        return add(v);
+    }
+    bool RawNumber(const char* v, rapidjson::SizeType length, bool copy) { return String(v, length, copy); }
+    bool String(const char* s, rapidjson::SizeType length, bool) {
+        jvalue v{jvalue::kind::string};
+        v.value_string = {s, length};
+        return add(v);
+    }
+    bool StartObject() { return start(jvalue::kind::object); }
+    bool Key(const char* s, rapidjson::SizeType length, bool) {
+        key = {s, length};
+        return true;
+    }
+    bool EndObject(rapidjson::SizeType) { return end(); }
+    bool StartArray() { return start(jvalue::kind::array); }
+    bool EndArray(rapidjson::SizeType) { return end(); }
 };
 
 struct jvalue_to_bin_state {
     eosio::vector_stream writer;
     const jvalue* received_value = nullptr;
     std::vector<jvalue_to_bin_stack_entry> stack{};
+    // For each object on the stack, the member holding each of its struct's fields, or null if it is missing
+    std::vector<const jvalue*> field_values{};
     bool skipped_extension = false;
 
     bool get_bool() const {
-      auto* b = std::get_if<bool>(&received_value->value);
-      eosio::check(b, eosio::convert_json_error(eosio::from_json_error::expected_bool));
-      return *b;
+      eosio::check(received_value->type == jvalue::kind::boolean,
+            eosio::convert_json_error(eosio::from_json_error::expected_bool));
+      return received_value->value_bool;
     }
 
     std::string_view get_string() const {
-        auto* s = std::get_if<std::string>(&received_value->value);
-        eosio::check(s, eosio::convert_json_error(eosio::from_json_error::expected_string));
-        return *s;
+        eosio::check(received_value->type == jvalue::kind::string,
+            eosio::convert_json_error(eosio::from_json_error::expected_string));
+        return received_value->value_string;
     }
     void get_null() {
-       eosio::check(std::holds_alternative<std::nullptr_t>(received_value->value),
+       eosio::check(received_value->type == jvalue::kind::null,
               eosio::convert_json_error(eosio::from_json_error::expected_null));
     }
     bool get_null_pred() {
-       return std::holds_alternative<std::nullptr_t>(received_value->value);
+       return received_value->type == jvalue::kind::null;
     }
 };
 
 struct json_to_bin_state : eosio::json_token_stream {
     using json_token_stream::json_token_stream;
     eosio::vector_stream& writer;
-    std::vector<size_insertion> size_insertions{};
-    std::vector<json_to_bin_stack_entry> stack{};
     bool skipped_extension = false;
 
     explicit json_to_bin_state(char* in, eosio::vector_stream& out)
       : eosio::json_token_stream(in), writer(out) {}
 };
 
-struct bin_to_json_state {
+template <typename Writer>
+struct basic_bin_to_json_state {
     eosio::input_stream& bin;
-    eosio::vector_stream& writer;
-    std::vector<bin_to_json_stack_entry> stack{};
+    Writer& writer;
     bool skipped_extension = false;
 
-    bin_to_json_state(eosio::input_stream& bin, eosio::vector_stream& writer)
+    basic_bin_to_json_state(eosio::input_stream& bin, Writer& writer)
         : bin{bin}, writer{writer} {}
 };
 
+using bin_to_json_state = basic_bin_to_json_state<eosio::vector_stream>;
+// Writes into caller-owned memory
+using bin_to_json_buf_state = basic_bin_to_json_state<eosio::bounded_buf_stream>;
+
+// Converts binary to a binary format: MessagePack or CBOR
+template <typename Writer>
+struct basic_bin_to_binary_state {
+    eosio::input_stream& bin;
+    Writer writer;
+};
+
+using bin_to_msgpack_state = basic_bin_to_binary_state<eosio::msgpack_writer>;
+using bin_to_cbor_state = basic_bin_to_binary_state<eosio::cbor_writer>;
+
+// Where a running abi_program is. An array or variant running its own program keeps its progress here.
+struct program_frame {
+    const eosio::abi_op* pc = nullptr;
+    const eosio::abi_op* end = nullptr;
+    bool allow_extensions = false;
+    bool started = false;
+    uint32_t index = 0;
+    uint32_t count = 0;
+    size_t size_position = 0;
+};
+
+// The running programs. depth counts the objects, arrays and variants open in them, which is limited the same
+// way as the serializer stack.
+struct program_stack {
+    std::vector<program_frame> frames{};
+    size_t depth = 0;
+
+    void push(const abi_type* type, bool allow_extensions) {
+        auto& ops = type->program().ops;
+        frames.push_back({ops.data(), ops.data() + ops.size(), allow_extensions});
+    }
+
+    void enter() {
+        eosio::check(++depth <= max_stack_size, eosio::convert_abi_error(eosio::abi_error::recursion_limit_reached));
+    }
+};
+
 }
 
 namespace eosio {
@@ -294,8 +343,24 @@ struct abi_serializer {
                                           bool start) const = 0;
   virtual void json_to_bin(::abieos::json_to_bin_state& state, bool allow_extensions, const abi_type* type,
                                           bool start) const = 0;
-  virtual void bin_to_json(::abieos::bin_to_json_state& state, bool allow_extensions, const abi_type* type,
-                                          bool start) const = 0;
+  virtual void bin_to_json(::abieos::bin_to_json_state& state, bool allow_extensions,
+                                          const abi_type* type) const = 0;
+  virtual void bin_to_json(::abieos::bin_to_json_buf_state& state, bool allow_extensions,
+                                          const abi_type* type) const = 0;
+  virtual void bin_to_binary(::abieos::bin_to_msgpack_state& state, bool allow_extensions,
+                                          const abi_type* type) const = 0;
+  virtual void bin_to_binary(::abieos::bin_to_cbor_state& state, bool allow_extensions,
+                                          const abi_type* type) const = 0;
+  // Advances bin past a value of type without converting it. depth counts the enclosing values.
+  virtual void skip_bin(eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                                          size_t depth) const = 0;
+  // Convert whole arrays of builtins with one call. Before array_bin_to_json, the caller checks that bin holds
+  // size elements of fixed-size types.
+  virtual void array_bin_to_json(::abieos::bin_to_json_state& state, const abi_type* type,
+                                          uint32_t size) const = 0;
+  virtual void array_bin_to_json(::abieos::bin_to_json_buf_state& state, const abi_type* type,
+                                          uint32_t size) const = 0;
+  virtual uint32_t array_json_to_bin(::abieos::json_to_bin_state& state, const abi_type* type) const = 0;
 };
 
 }
@@ -333,16 +398,46 @@ void json_to_bin(pseudo_array*, json_to_bin_state& state, bool allow_extensions,
 void json_to_bin(pseudo_variant*, json_to_bin_state& state, bool allow_extensions,
                                 const abi_type* type, bool start);
 
-void bin_to_json(pseudo_optional*, bin_to_json_state& state, bool allow_extensions,
-                                const abi_type* type, bool start);
-void bin_to_json(pseudo_extension*, bin_to_json_state& state, bool allow_extensions,
-                                const abi_type* type, bool start);
-void bin_to_json(pseudo_object*, bin_to_json_state& state, bool allow_extensions, const abi_type* type,
-                                bool start);
-void bin_to_json(pseudo_array*, bin_to_json_state& state, bool allow_extensions, const abi_type* type,
-                                bool start);
-void bin_to_json(pseudo_variant*, bin_to_json_state& state, bool allow_extensions,
-                                const abi_type* type, bool start);
+template <typename State>
+void bin_to_json(pseudo_optional*, State& state, bool allow_extensions, const abi_type* type);
+template <typename State>
+void bin_to_json(pseudo_extension*, State& state, bool allow_extensions, const abi_type* type);
+template <typename State>
+void bin_to_json(pseudo_object*, State& state, bool allow_extensions, const abi_type* type);
+template <typename State>
+void bin_to_json(pseudo_array*, State& state, bool allow_extensions, const abi_type* type);
+template <typename State>
+void bin_to_json(pseudo_variant*, State& state, bool allow_extensions, const abi_type* type);
+
+template <typename T, typename State>
+auto bin_to_binary(T* t, State& state, bool allow_extensions, const abi_type* type)
+    -> std::void_t<decltype(from_bin(*t, state.bin))>;
+template <typename State>
+void bin_to_binary(eosio::bytes*, State& state, bool allow_extensions, const abi_type* type);
+template <typename State>
+void bin_to_binary(pseudo_optional*, State& state, bool allow_extensions, const abi_type* type);
+template <typename State>
+void bin_to_binary(pseudo_extension*, State& state, bool allow_extensions, const abi_type* type);
+template <typename State>
+void bin_to_binary(pseudo_object*, State& state, bool allow_extensions, const abi_type* type);
+template <typename State>
+void bin_to_binary(pseudo_array*, State& state, bool allow_extensions, const abi_type* type);
+template <typename State>
+void bin_to_binary(pseudo_variant*, State& state, bool allow_extensions, const abi_type* type);
+
+template <typename T>
+auto skip_bin(T* t, eosio::input_stream& bin, bool allow_extensions, const abi_type* type, size_t depth)
+    -> std::void_t<decltype(from_bin(*t, bin))>;
+void skip_bin(pseudo_optional*, eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                                size_t depth);
+void skip_bin(pseudo_extension*, eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                                size_t depth);
+void skip_bin(pseudo_object*, eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                                size_t depth);
+void skip_bin(pseudo_array*, eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                                size_t depth);
+void skip_bin(pseudo_variant*, eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                                size_t depth);
 
 ///////////////////////////////////////////////////////////////////////////////
 // serializable types
@@ -353,16 +448,16 @@ using eosio::bytes;
 template <typename State>
 void json_to_bin(bytes*, State& state, bool, const abi_type*, bool start) {
     auto s = state.get_string();;
-    if (trace_json_to_bin)
-        printf("%*sbytes (%d hex digits)\n", int(state.stack.size() * 4), "", int(s.size()));
     eosio::check( !(s.size() & 1), eosio::convert_json_error(eosio::from_json_error::expected_hex_string) );
     eosio::varuint32_to_bin(s.size() / 2, state.writer);
-    // FIXME: Add a function to encode a hex string to a stream
-    eosio::check(eosio::unhex(std::back_inserter(state.writer.data), s.begin(), s.end()),
+    auto& data = state.writer.data;
+    data.resize(data.size() + s.size() / 2);
+    eosio::check(eosio::hex_decode(s.data(), s.size(), data.data() + data.size() - s.size() / 2),
         eosio::convert_json_error(eosio::from_json_error::expected_hex_string));
 }
 
-inline void bin_to_json(bytes*, bin_to_json_state& state, bool, const abi_type*, bool start) {
+template <typename State>
+void bin_to_json(bytes*, State& state, bool, const abi_type*) {
     uint64_t size;
     varuint64_from_bin(size, state.bin);
     const char* data;
@@ -370,6 +465,15 @@ inline void bin_to_json(bytes*, bin_to_json_state& state, bool, const abi_type*,
     return to_json_hex(data, size, state.writer);
 }
 
+template <typename State>
+void bin_to_json(std::string*, State& state, bool, const abi_type*) {
+    uint32_t size;
+    varuint32_from_bin(size, state.bin);
+    const char* data;
+    state.bin.read_reuse_storage(data, size);
+    return to_json(std::string_view{data, size}, state.writer);
+}
+
 using eosio::float128;
 using eosio::checksum160;
 using eosio::checksum256;
@@ -469,108 +573,19 @@ ABIEOS_NODISCARD inline bool check_abi_version(const std::string& s, std::string
 // json_to_jvalue
 ///////////////////////////////////////////////////////////////////////////////
 
-ABIEOS_NODISCARD bool json_to_jobject(jvalue& value, json_to_jvalue_state& state, event_type event, bool start);
-ABIEOS_NODISCARD bool json_to_jarray(jvalue& value, json_to_jvalue_state& state, event_type event, bool start);
-
-ABIEOS_NODISCARD inline bool receive_event(struct json_to_jvalue_state& state, event_type event, bool start) {
-    if (state.stack.empty())
-        return set_error(state, "extra data");
-    if (state.stack.size() > max_stack_size)
-        return set_error(state, "recursion limit reached");
-    if (trace_json_to_jvalue_event)
-        printf("(event %d)\n", (int)event);
-    auto& v = *state.stack.back().value;
-    if (start) {
-        state.stack.pop_back();
-        if (event == event_type::received_null) {
-            v.value = nullptr;
-        } else if (event == event_type::received_bool) {
-            v.value = state.get_bool();
-        } else if (event == event_type::received_string) {
-            v.value = std::move(state.get_string());
-        } else if (event == event_type::received_start_object) {
-            v.value = jobject{};
-            return json_to_jobject(v, state, event, start);
-        } else if (event == event_type::received_start_array) {
-            v.value = jarray{};
-            return json_to_jarray(v, state, event, start);
-        } else {
-            return false;
-        }
-    } else {
-        if (std::holds_alternative<jobject>(v.value))
-            return json_to_jobject(v, state, event, start);
-        else if (std::holds_alternative<jarray>(v.value))
-            return json_to_jarray(v, state, event, start);
-        else
-            return set_error(state, "extra data");
-    }
-    return true;
-}
-
+// Parses json, which must be followed by 3 zero bytes, in place into arena. The result points into json.
 template<typename F>
-inline void json_to_jvalue(jvalue& value, std::string_view json, F&& f) {
-    std::string mutable_json{json};
-    mutable_json.push_back(0);
-    mutable_json.push_back(0);
-    mutable_json.push_back(0);
-    std::string error; // !!!
-    json_to_jvalue_state state{error};
-    state.stack.push_back({&value});
+inline const jvalue& json_to_jvalue(json_arena& arena, char* json, F&& f) {
+    json_to_jvalue_state state{arena};
     rapidjson::Reader reader;
-    rapidjson::InsituStringStream ss(mutable_json.data());
-    eosio::check(reader.Parse<rapidjson::kParseValidateEncodingFlag | rapidjson::kParseIterativeFlag |
-        rapidjson::kParseNumbersAsStringsFlag>(ss, state),
+    rapidjson::InsituStringStream ss(json);
+    eosio::check(reader.Parse<rapidjson::kParseInsituFlag | rapidjson::kParseValidateEncodingFlag |
+        rapidjson::kParseIterativeFlag | rapidjson::kParseNumbersAsStringsFlag>(ss, state) &&
+        state.pending.size() == 1,
         eosio::convert_json_error(eosio::from_json_error::unspecific_syntax_error));
-}
-
-ABIEOS_NODISCARD inline bool json_to_jobject(jvalue& value, json_to_jvalue_state& state, event_type event, bool start) {
-    if (start) {
-        if (event != event_type::received_start_object)
-            return set_error(state, "expected object");
-        if (trace_json_to_jvalue)
-            printf("%*s{\n", int(state.stack.size() * 4), "");
-        state.stack.push_back({&value});
-        return true;
-    } else if (event == event_type::received_end_object) {
-        if (trace_json_to_jvalue)
-            printf("%*s}\n", int((state.stack.size() - 1) * 4), "");
-        state.stack.pop_back();
-        return true;
-    }
-    auto& stack_entry = state.stack.back();
-    if (event == event_type::received_key) {
-        stack_entry.key = std::move(state.received_data.key);
-        return true;
-    } else {
-        if (trace_json_to_jvalue)
-            printf("%*sfield %s (event %d)\n", int(state.stack.size() * 4), "", stack_entry.key.c_str(), (int)event);
-        auto& x = std::get<jobject>(value.value)[stack_entry.key] = {};
-        state.stack.push_back({&x});
-        return receive_event(state, event, true);
-    }
-}
-
-ABIEOS_NODISCARD inline bool json_to_jarray(jvalue& value, json_to_jvalue_state& state, event_type event, bool start) {
-    if (start) {
-        if (event != event_type::received_start_array)
-            return set_error(state, "expected array");
-        if (trace_json_to_jvalue)
-            printf("%*s[\n", int(state.stack.size() * 4), "");
-        state.stack.push_back({&value});
-        return true;
-    } else if (event == event_type::received_end_array) {
-        if (trace_json_to_jvalue)
-            printf("%*s]\n", int((state.stack.size() - 1) * 4), "");
-        state.stack.pop_back();
-        return true;
-    }
-    auto& v = std::get<jarray>(value.value);
-    if (trace_json_to_jvalue)
-        printf("%*sitem %d (event %d)\n", int(state.stack.size() * 4), "", int(v.size()), (int)event);
-    v.emplace_back();
-    state.stack.push_back({&v.back()});
-    return receive_event(state, event, true);
+    auto* root = arena.allocate(1);
+    *root = state.pending[0];
+    return *root;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -619,12 +634,18 @@ inline void json_to_bin(pseudo_extension*, State& state, bool allow_extensions,
 inline void json_to_bin(pseudo_object*, jvalue_to_bin_state& state, bool allow_extensions,
                                        const abi_type* type, bool start) {
     if (start) {
-       eosio::check(!(!state.received_value || !std::holds_alternative<jobject>(state.received_value->value)),
+       eosio::check(!(!state.received_value || state.received_value->type != jvalue::kind::object),
             eosio::convert_json_error(eosio::from_json_error::expected_start_object));
+        auto* s = type->as_struct();
         if (trace_jvalue_to_bin)
-            printf("%*s{ %d fields, allow_ex=%d\n", int(state.stack.size() * 4), "", int(type->as_struct()->fields.size()),
+            printf("%*s{ %d fields, allow_ex=%d\n", int(state.stack.size() * 4), "", int(s->fields.size()),
                    allow_extensions);
-        state.stack.push_back({type, allow_extensions, state.received_value, -1});
+        // match members to fields once; for repeated keys the last one wins
+        auto field_values = state.field_values.size();
+        state.field_values.resize(field_values + s->fields.size());
+        for (auto& member : *state.received_value)
+            s->find_fields(member.key, [&](uint32_t i) { state.field_values[field_values + i] = &member; });
+        state.stack.push_back({type, allow_extensions, state.received_value, -1, field_values});
     }
     auto& stack_entry = state.stack.back();
     ++stack_entry.position;
@@ -632,16 +653,16 @@ inline void json_to_bin(pseudo_object*, jvalue_to_bin_state& state, bool allow_e
     if (stack_entry.position == (int)fields.size()) {
         if (trace_jvalue_to_bin)
             printf("%*s}\n", int((state.stack.size() - 1) * 4), "");
+        state.field_values.resize(stack_entry.field_values);
         state.stack.pop_back();
         return;
     }
     auto& field = fields[stack_entry.position];
-    auto& obj = std::get<jobject>(stack_entry.value->value);
-    auto it = obj.find(field.name);
+    auto* value = state.field_values[stack_entry.field_values + stack_entry.position];
     if (trace_jvalue_to_bin)
         printf("%*sfield %d/%d: %s\n", int(state.stack.size() * 4), "", int(stack_entry.position),
                int(fields.size()), std::string{field.name}.c_str());
-    if (it == obj.end()) {
+    if (!value) {
         if (field.type->extension_of() && allow_extensions) {
             state.skipped_extension = true;
             return;
@@ -651,7 +672,7 @@ inline void json_to_bin(pseudo_object*, jvalue_to_bin_state& state, bool allow_e
     }
     eosio::check(!state.skipped_extension,
         eosio::convert_json_error(eosio::from_json_error::unexpected_field));
-    state.received_value = &it->second;
+    state.received_value = value;
     return field.type->ser->json_to_bin(state, allow_extensions && &field == &fields.back(),
                                         field.type, true);
 }
@@ -659,18 +680,17 @@ inline void json_to_bin(pseudo_object*, jvalue_to_bin_state& state, bool allow_e
 inline void json_to_bin(pseudo_array*, jvalue_to_bin_state& state, bool, const abi_type* type,
                                        bool start) {
     if (start) {
-       eosio::check(!(!state.received_value || !std::holds_alternative<jarray>(state.received_value->value)),
+       eosio::check(!(!state.received_value || state.received_value->type != jvalue::kind::array),
             eosio::convert_json_error(eosio::from_json_error::expected_start_array));
         if (trace_jvalue_to_bin)
-            printf("%*s[ %d elements\n", int(state.stack.size() * 4), "",
-                   int(std::get<jarray>(state.received_value->value).size()));
-        eosio::varuint32_to_bin(std::get<jarray>(state.received_value->value).size(), state.writer);
+            printf("%*s[ %d elements\n", int(state.stack.size() * 4), "", int(state.received_value->size));
+        eosio::varuint32_to_bin(state.received_value->size, state.writer);
         state.stack.push_back({type, false, state.received_value, -1});
     }
     auto& stack_entry = state.stack.back();
-    auto& arr = std::get<jarray>(stack_entry.value->value);
+    auto* arr = stack_entry.value->children;
     ++stack_entry.position;
-    if (stack_entry.position == (int)arr.size()) {
+    if (stack_entry.position == (int)stack_entry.value->size) {
         if (trace_jvalue_to_bin)
             printf("%*s]\n", int((state.stack.size() - 1) * 4), "");
         state.stack.pop_back();
@@ -686,31 +706,29 @@ inline void json_to_bin(pseudo_array*, jvalue_to_bin_state& state, bool, const a
 inline void json_to_bin(pseudo_variant*, jvalue_to_bin_state& state, bool allow_extensions,
                                        const abi_type* type, bool start) {
     if (start) {
-       eosio::check(!(!state.received_value || !std::holds_alternative<jarray>(state.received_value->value)),
+       eosio::check(!(!state.received_value || state.received_value->type != jvalue::kind::array),
             eosio::convert_json_error(eosio::from_json_error::expected_variant));
-        auto& arr = std::get<jarray>(state.received_value->value);
-        eosio::check(arr.size() == 2,
+        auto* arr = state.received_value->children;
+        eosio::check(state.received_value->size == 2,
             eosio::convert_json_error(eosio::from_json_error::expected_variant));
-        eosio::check(std::holds_alternative<std::string>(arr[0].value),
+        eosio::check(arr[0].type == jvalue::kind::string,
             eosio::convert_json_error(eosio::from_json_error::expected_variant));
-        auto& typeName = std::get<std::string>(arr[0].value);
         if (trace_jvalue_to_bin)
-            printf("%*s[ variant %s\n", int(state.stack.size() * 4), "", typeName.c_str());
+            printf("%*s[ variant %.*s\n", int(state.stack.size() * 4), "", int(arr[0].value_string.size()),
+                   arr[0].value_string.data());
         state.stack.push_back({type, allow_extensions, state.received_value, 0});
         return;
     }
     auto& stack_entry = state.stack.back();
-    auto& arr = std::get<jarray>(stack_entry.value->value);
+    auto* arr = stack_entry.value->children;
     if (stack_entry.position == 0) {
-        auto& typeName = std::get<std::string>(arr[0].value);
-        const std::vector<eosio::abi_field>& fields = *stack_entry.type->as_variant();
-        auto it = std::find_if(fields.begin(), fields.end(),
-                               [&](auto& field) { return field.name == typeName; });
-        eosio::check(it != fields.end(),
+        auto& fields = *stack_entry.type->as_variant();
+        auto* field = fields.find(arr[0].value_string);
+        eosio::check(field,
             eosio::convert_json_error(eosio::from_json_error::invalid_type_for_variant));
-        eosio::varuint32_to_bin(it - fields.begin(), state.writer);
+        eosio::varuint32_to_bin(field - fields.data(), state.writer);
         state.received_value = &arr[++stack_entry.position];
-        return it->type->ser->json_to_bin(state, allow_extensions, it->type, true);
+        return field->type->ser->json_to_bin(state, allow_extensions, field->type, true);
     } else {
         if (trace_jvalue_to_bin)
             printf("%*s]\n", int((state.stack.size() - 1) * 4), "");
@@ -730,8 +748,6 @@ template <typename State>
 inline void json_to_bin(std::string*, State& state, bool, const abi_type*,
                                        bool start) {
     auto s = state.get_string();
-    if (trace_jvalue_to_bin)
-        printf("%*sstring: %.*s\n", int(state.stack.size() * 4), "", (int)s.size(), s.data());
     return to_bin(s, state.writer);
 }
 
@@ -739,275 +755,957 @@ inline void json_to_bin(std::string*, State& state, bool, const abi_type*,
 // json_to_bin
 ///////////////////////////////////////////////////////////////////////////////
 
+// Replaces the 1-byte placeholder at pos with size as a varuint32. Sizes of 128 and up need more bytes, so
+// only then is the data after the placeholder moved.
+inline void backpatch_size(std::vector<char>& data, size_t pos, uint32_t size) {
+    if (size < 0x80) {
+        data[pos] = char(size);
+        return;
+    }
+    char buf[5];
+    size_t len = 0;
+    do {
+        uint8_t b = size & 0x7f;
+        size >>= 7;
+        b |= ((size > 0) << 7);
+        buf[len++] = char(b);
+    } while (size);
+    data.insert(data.begin() + pos + 1, len - 1, 0);
+    memcpy(data.data() + pos, buf, len);
+}
+
+// Converts count fixed-size fields from field on, with their keys
+inline void fixed_fields_from_json(json_to_bin_state& state, const eosio::abi_field* field, uint32_t count,
+                                   uint32_t size) {
+    auto& data = state.writer.data;
+    if (data.capacity() < data.size() + size)
+        data.reserve(std::max(data.size() + size, data.capacity() * 2));
+    for (auto* end = field + count; field != end; ++field) {
+        eosio::check(!state.get_end_object_pred(), eosio::convert_json_error(eosio::from_json_error::expected_field));
+        auto key = state.maybe_get_key();
+        eosio::check(key && !state.skipped_extension,
+            eosio::convert_json_error(eosio::from_json_error::unexpected_field));
+        eosio::check(*key == field->name, eosio::convert_json_error(eosio::from_json_error::expected_field));
+        field->type->ser->json_to_bin(state, false, field->type, true);
+    }
+}
+
+// Runs type's program over the json tokens in state
 template<typename F>
-inline void json_to_bin(std::vector<char>& bin, const abi_type* type, std::string_view json, F&& f) {
+void run_json_to_bin(json_to_bin_state& state, const abi_type* type, bool allow_extensions, F&& f) {
+    using eosio::abi_op;
+    program_stack stack;
+    stack.push(type, allow_extensions);
+    while (!stack.frames.empty()) {
+        f();
+        auto& frame = stack.frames.back();
+        if (frame.pc == frame.end) {
+            stack.frames.pop_back();
+            continue;
+        }
+        auto& op = *frame.pc;
+        bool allow_extensions = frame.allow_extensions && op.allow;
+        switch (op.code) {
+        case abi_op::builtin:
+            op.type->ser->json_to_bin(state, allow_extensions, op.type, true);
+            ++frame.pc;
+            break;
+        case abi_op::call:
+            ++frame.pc;
+            stack.push(op.type, allow_extensions);
+            break;
+        case abi_op::begin_object:
+            state.get_start_object();
+            stack.enter();
+            ++frame.pc;
+            break;
+        case abi_op::key:
+            if (state.get_end_object_pred()) {
+                // the object may end early only by omitting an extension
+                eosio::check(op.field->type->extension_of() && allow_extensions,
+                    eosio::convert_json_error(eosio::from_json_error::expected_field));
+                state.skipped_extension = true;
+                --stack.depth;
+                frame.pc += op.end;
+                break;
+            }
+            {
+                auto key = state.maybe_get_key();
+                eosio::check(key && !state.skipped_extension,
+                    eosio::convert_json_error(eosio::from_json_error::unexpected_field));
+                eosio::check(*key == op.field->name, eosio::convert_json_error(eosio::from_json_error::expected_field));
+            }
+            ++frame.pc;
+            break;
+        case abi_op::fixed:
+            fixed_fields_from_json(state, op.field, op.count, op.size);
+            ++frame.pc;
+            break;
+        case abi_op::end_object:
+            eosio::check(state.get_end_object_pred(),
+                eosio::convert_json_error(eosio::from_json_error::unexpected_field));
+            --stack.depth;
+            ++frame.pc;
+            break;
+        case abi_op::optional:
+            if (state.get_null_pred()) {
+                state.writer.write(char(0));
+                frame.pc += 1 + op.skip;
+            } else {
+                state.writer.write(char(1));
+                ++frame.pc;
+            }
+            break;
+        case abi_op::array:
+            if (op.first) {
+                auto* t = op.type->array_of();
+                state.get_start_array();
+                auto size_position = state.writer.data.size();
+                state.writer.write(char(0));
+                uint32_t size = 0;
+                if (auto* s = t->as_struct()) {
+                    for (; !state.get_end_array_pred(); ++size) {
+                        state.get_start_object();
+                        fixed_fields_from_json(state, s->fields.data(), s->fields.size(), op.size);
+                        eosio::check(state.get_end_object_pred(),
+                            eosio::convert_json_error(eosio::from_json_error::unexpected_field));
+                    }
+                } else {
+                    size = t->ser->array_json_to_bin(state, t);
+                }
+                backpatch_size(state.writer.data, size_position, size);
+                ++frame.pc;
+            } else if (!frame.started) {
+                state.get_start_array();
+                stack.enter();
+                frame.started = true;
+                frame.size_position = state.writer.data.size();
+                state.writer.write(char(0));
+            } else if (state.get_end_array_pred()) {
+                backpatch_size(state.writer.data, frame.size_position, frame.count);
+                --stack.depth;
+                ++frame.pc;
+            } else {
+                ++frame.count;
+                stack.push(op.type->array_of(), false);
+            }
+            break;
+        case abi_op::variant:
+            if (!frame.started) {
+                state.get_start_array();
+                stack.enter();
+                frame.started = true;
+                eosio::check(!state.get_end_array_pred(),
+                    eosio::convert_json_error(eosio::from_json_error::expected_variant));
+                auto& fields = *op.type->as_variant();
+                auto* field = fields.find(state.get_string());
+                eosio::check(field,
+                    eosio::convert_json_error(eosio::from_json_error::invalid_type_for_variant));
+                eosio::varuint32_to_bin(field - fields.data(), state.writer);
+                eosio::check(!state.get_end_array_pred(),
+                    eosio::convert_json_error(eosio::from_json_error::expected_variant));
+                stack.push(field->type, allow_extensions);
+            } else {
+                eosio::check(state.get_end_array_pred(),
+                    eosio::convert_json_error(eosio::from_json_error::expected_variant));
+                --stack.depth;
+                ++frame.pc;
+            }
+            break;
+        }
+    }
+}
+
+// Appends the binary to out in a single pass; array sizes are backpatched once each array ends. json must be
+// followed by 3 zero bytes. It is parsed in place, which overwrites it.
+template<typename F>
+inline void json_to_bin_insitu(eosio::vector_stream& out, const abi_type* type, char* json, F&& f) {
+    json_to_bin_state state(json, out);
+    run_json_to_bin(state, type, true, f);
+    eosio::check(state.complete(),
+        eosio::convert_json_error(eosio::from_json_error::expected_end));
+}
+
+// Appends the binary to out, parsing a copy of json
+template<typename F>
+inline void json_to_bin(eosio::vector_stream& out, const abi_type* type, std::string_view json, F&& f) {
     std::string mutable_json{json};
     mutable_json.push_back(0);
     mutable_json.push_back(0);
     mutable_json.push_back(0);
-    std::vector<char> out_buf;
-    eosio::vector_stream out(out_buf);
-    json_to_bin_state state(mutable_json.data(), out);
+    json_to_bin_insitu(out, type, mutable_json.data(), f);
+}
 
-    type->ser->json_to_bin(state, true, type, true);
-    while(!state.stack.empty()) {
-        f();
-        auto entry = state.stack.back();
-        auto* type = entry.type;
-        eosio::check(state.stack.size() <= max_stack_size,
-            eosio::convert_abi_error(eosio::abi_error::recursion_limit_reached));
-        type->ser->json_to_bin(state, entry.allow_extensions, type, false);
-    }
-    eosio::check(state.complete(),
-        eosio::convert_json_error(eosio::from_json_error::expected_end));
+// Writes the binary to dest, which may be any output stream. It is encoded into a temporary buffer first, where
+// array sizes can be backpatched, then copied to dest.
+template<typename S, typename F>
+inline void json_to_bin(S& dest, const abi_type* type, std::string_view json, F&& f) {
+    std::vector<char> bin;
+    eosio::vector_stream out{bin};
+    json_to_bin(out, type, json, f);
+    dest.write(bin.data(), bin.size());
+}
 
-    size_t pos = 0;
-    for (auto& insertion : state.size_insertions) {
-        bin.insert(bin.end(), out_buf.begin() + pos, out_buf.begin() + insertion.position);
-        eosio::push_varuint32(bin, insertion.size);
-        pos = insertion.position;
-    }
-    bin.insert(bin.end(), out_buf.begin() + pos, out_buf.end());
+// Appends the binary to bin
+template<typename F>
+inline void json_to_bin(std::vector<char>& bin, const abi_type* type, std::string_view json, F&& f) {
+    eosio::vector_stream dest{bin};
+    json_to_bin(dest, type, json, f);
 }
 
-inline void json_to_bin(pseudo_object*, json_to_bin_state& state, bool allow_extensions,
-                                       const abi_type* type, bool start) {
-    if (start) {
-        state.get_start_object();
-        if (trace_json_to_bin)
-            printf("%*s{ %d fields, allow_ex=%d\n", int(state.stack.size() * 4), "", int(type->as_struct()->fields.size()),
-                   allow_extensions);
-        state.stack.push_back({type, allow_extensions});
-    }
-    auto& stack_entry = state.stack.back();
-    const std::vector<eosio::abi_field>& fields = type->as_struct()->fields;
-    if (state.get_end_object_pred()) {
-        if (stack_entry.position + 1 != (ptrdiff_t)fields.size()) {
-            auto& field = fields[stack_entry.position + 1];
-            if (!field.type->extension_of() || !allow_extensions) {
-                stack_entry.position = -1;
-                eosio::check(false, eosio::convert_json_error(eosio::from_json_error::expected_field));
-            }
-            ++stack_entry.position;
-            state.skipped_extension = true;
-        }
-        if (trace_json_to_bin)
-            printf("%*s}\n", int((state.stack.size() - 1) * 4), "");
-        state.stack.pop_back();
-        return;
-    }
-    auto key = state.maybe_get_key();
-    if (key) {
-       eosio::check(!(++stack_entry.position >= (ptrdiff_t)fields.size() || state.skipped_extension),
-             eosio::convert_json_error(eosio::from_json_error::unexpected_field));
-        auto& field = fields[stack_entry.position];
-        if (*key != field.name) {
-            stack_entry.position = -1;
-            eosio::check(false, eosio::convert_json_error(eosio::from_json_error::expected_field));
-        }
-    } else {
-        auto& field = fields[stack_entry.position];
-        if (trace_json_to_bin)
-            printf("%*sfield %d/%d: %s\n", int(state.stack.size() * 4), "", int(stack_entry.position),
-                   int(fields.size()), std::string{field.name}.c_str());
-        field.type->ser->json_to_bin(state, allow_extensions && &field == &fields.back(), field.type,
-                                            true);
-    }
+// Composite types met outside of a program, such as a struct too deep to be inlined, run their own
+inline void json_to_bin(pseudo_object*, json_to_bin_state& state, bool allow_extensions, const abi_type* type,
+                        bool) {
+    run_json_to_bin(state, type, allow_extensions, [] {});
 }
 
-inline void json_to_bin(pseudo_array*, json_to_bin_state& state, bool, const abi_type* type,
-                                       bool start) {
-    if (start) {
-        state.get_start_array();
-        if (trace_json_to_bin)
-            printf("%*s[\n", int(state.stack.size() * 4), "");
-        state.stack.push_back({type, false});
-        state.stack.back().size_insertion_index = state.size_insertions.size();
-        // FIXME: add Stream::tellp or similar.
-        state.size_insertions.push_back({state.writer.data.size()});
-        return;
-    }
-    auto& stack_entry = state.stack.back();
-    if (state.get_end_array_pred()) {
-        if (trace_json_to_bin)
-            printf("%*s]\n", int((state.stack.size() - 1) * 4), "");
-        state.size_insertions[stack_entry.size_insertion_index].size = stack_entry.position + 1;
-        state.stack.pop_back();
-        return;
-    }
-    ++stack_entry.position;
-    if (trace_json_to_bin)
-        printf("%*sitem\n", int(state.stack.size() * 4), "");
-    const abi_type* t = type->array_of();
-    t->ser->json_to_bin(state, false, t, true);
+inline void json_to_bin(pseudo_array*, json_to_bin_state& state, bool allow_extensions, const abi_type* type,
+                        bool) {
+    run_json_to_bin(state, type, allow_extensions, [] {});
 }
 
-inline void json_to_bin(pseudo_variant*, json_to_bin_state& state, bool allow_extensions,
-                                       const abi_type* type, bool start) {
-    if (start) {
-        state.get_start_array();
-        if (trace_json_to_bin)
-            printf("%*s[ variant\n", int(state.stack.size() * 4), "");
-        state.stack.push_back({type, allow_extensions});
-        return;
-    }
-    auto& stack_entry = state.stack.back();
-    ++stack_entry.position;
-    if (state.get_end_array_pred()) {
-       eosio::check(stack_entry.position == 2,
-            eosio::convert_json_error(eosio::from_json_error::expected_variant));
-        if (trace_json_to_bin)
-            printf("%*s]\n", int((state.stack.size() - 1) * 4), "");
-        state.stack.pop_back();
-        return;
-    }
-    const std::vector<eosio::abi_field>& fields = *stack_entry.type->as_variant();
-    if (stack_entry.position == 0) {
-        auto typeName = state.get_string();
-        if (trace_json_to_bin)
-            printf("%*stype: %.*s\n", int(state.stack.size() * 4), "", (int)typeName.size(), typeName.data());
-        auto it = std::find_if(fields.begin(), fields.end(),
-                               [&](auto& field) { return field.name == typeName; });
-        eosio::check(it != fields.end(),
-            eosio::convert_json_error(eosio::from_json_error::invalid_type_for_variant));
-        stack_entry.variant_type_index = it - fields.begin();
-        eosio::varuint32_to_bin(stack_entry.variant_type_index, state.writer);
-    } else if (stack_entry.position == 1) {
-        auto& field = fields[stack_entry.variant_type_index];
-        field.type->ser->json_to_bin(state, allow_extensions, field.type, true);
-    } else {
-       eosio::check(false, eosio::convert_json_error(eosio::from_json_error::expected_variant));
-    }
+inline void json_to_bin(pseudo_variant*, json_to_bin_state& state, bool allow_extensions, const abi_type* type,
+                        bool) {
+    run_json_to_bin(state, type, allow_extensions, [] {});
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // bin_to_json
 ///////////////////////////////////////////////////////////////////////////////
 
+// Converts count fixed-size fields from field on, with their keys. The caller checks that their bytes are
+// available, so each field is converted by the array kernel of its type, which reads numbers, names and
+// checksums straight from the input.
+template <typename State>
+void fixed_fields_to_json(State& state, const eosio::abi_field* field, uint32_t count, bool first) {
+    for (auto* end = field + count; field != end; ++field, first = false) {
+        if (!first)
+            state.writer.write(',');
+        write_key(*field, state.writer);
+        field->type->ser->array_bin_to_json(state, field->type, 1);
+    }
+}
+
+// Runs type's program over the binary in state. allow_extensions is false for values followed by more of the
+// binary.
+template<typename State, typename F>
+void run_bin_to_json(State& state, const abi_type* type, bool allow_extensions, F&& f) {
+    using eosio::abi_op;
+    auto& writer = state.writer;
+    program_stack stack;
+    stack.push(type, allow_extensions);
+    while (!stack.frames.empty()) {
+        f();
+        auto& frame = stack.frames.back();
+        if (frame.pc == frame.end) {
+            stack.frames.pop_back();
+            continue;
+        }
+        auto& op = *frame.pc;
+        bool allow_extensions = frame.allow_extensions && op.allow;
+        switch (op.code) {
+        case abi_op::builtin:
+            op.type->ser->bin_to_json(state, allow_extensions, op.type);
+            ++frame.pc;
+            break;
+        case abi_op::call:
+            ++frame.pc;
+            stack.push(op.type, allow_extensions);
+            break;
+        case abi_op::begin_object:
+            stack.enter();
+            writer.write('{');
+            ++frame.pc;
+            break;
+        case abi_op::key:
+            if (state.bin.pos == state.bin.end && op.field->type->extension_of() && allow_extensions) {
+                state.skipped_extension = true;
+                frame.pc += 1 + op.skip;
+                break;
+            }
+            if (!op.first)
+                writer.write(',');
+            write_key(*op.field, writer);
+            ++frame.pc;
+            break;
+        case abi_op::fixed:
+            state.bin.check_available(op.size);
+            fixed_fields_to_json(state, op.field, op.count, op.first);
+            ++frame.pc;
+            break;
+        case abi_op::end_object:
+            --stack.depth;
+            writer.write('}');
+            ++frame.pc;
+            break;
+        case abi_op::optional: {
+            bool present;
+            from_bin(present, state.bin);
+            if (present) {
+                ++frame.pc;
+            } else {
+                writer.write("null", 4);
+                frame.pc += 1 + op.skip;
+            }
+            break;
+        }
+        case abi_op::array:
+            if (op.first) {
+                auto* t = op.type->array_of();
+                uint32_t size;
+                varuint32_from_bin(size, state.bin);
+                state.bin.check_available(uint64_t(size) * op.size);
+                writer.write('[');
+                if (auto* s = t->as_struct()) {
+                    for (uint32_t i = 0; i < size; ++i) {
+                        if (i)
+                            writer.write(',');
+                        writer.write('{');
+                        fixed_fields_to_json(state, s->fields.data(), s->fields.size(), true);
+                        writer.write('}');
+                    }
+                } else {
+                    t->ser->array_bin_to_json(state, t, size);
+                }
+                writer.write(']');
+                ++frame.pc;
+            } else if (!frame.started) {
+                stack.enter();
+                frame.started = true;
+                varuint32_from_bin(frame.count, state.bin);
+                writer.write('[');
+            } else if (frame.index < frame.count) {
+                if (frame.index++)
+                    writer.write(',');
+                stack.push(op.type->array_of(), false);
+            } else {
+                --stack.depth;
+                writer.write(']');
+                ++frame.pc;
+            }
+            break;
+        case abi_op::variant:
+            if (!frame.started) {
+                stack.enter();
+                frame.started = true;
+                writer.write('[');
+                uint32_t index;
+                varuint32_from_bin(index, state.bin);
+                const std::vector<eosio::abi_field>& fields = *op.type->as_variant();
+                EOS_CHECK(index < fields.size(), std::string(eosio::convert_stream_error(eosio::stream_error::bad_variant_index)) + " of type " + op.type->name);
+                auto& field = fields[index];
+                write_alternative(field, writer);
+                writer.write(',');
+                stack.push(field.type, allow_extensions);
+            } else {
+                --stack.depth;
+                writer.write(']');
+                ++frame.pc;
+            }
+            break;
+        }
+    }
+}
+
+// Appends the json to writer
+template<typename Writer, typename F>
+inline void bin_to_json(eosio::input_stream& bin, const abi_type* type, Writer& writer, F&& f,
+                        bool allow_extensions = true) {
+    basic_bin_to_json_state<Writer> state{bin, writer};
+    run_bin_to_json(state, type, allow_extensions, f);
+}
+
 template<typename F>
 inline void bin_to_json(eosio::input_stream& bin, const abi_type* type, std::string& dest, F&& f) {
     // FIXME: Write directly to the string instead of creating an additional buffer
     std::vector<char> buffer;
     eosio::vector_stream writer{buffer};
-    bin_to_json_state state{bin, writer};
-    type->ser->bin_to_json(state, true, type, true);
-    while (!state.stack.empty()) {
-        f();
-        auto& entry = state.stack.back();
-        entry.type->ser->bin_to_json(state, entry.allow_extensions, entry.type, false);
-        eosio::check(state.stack.size() <= max_stack_size,
-            eosio::convert_abi_error(eosio::abi_error::recursion_limit_reached));
-    }
+    bin_to_json(bin, type, writer, f);
     dest = std::string_view(writer.data.data(), writer.data.size());
 }
 
-inline void bin_to_json(bin_to_json_state& state, bool allow_extensions, const abi_type* type, bool start) {
-    type->ser->bin_to_json(state, allow_extensions, type, start);
+// Composite types met outside of a program, such as a struct too deep to be inlined, run their own
+template <typename State>
+inline void bin_to_json(pseudo_optional*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_json(state, type, allow_extensions, [] {});
 }
 
-inline void bin_to_json(pseudo_optional*, bin_to_json_state& state, bool allow_extensions,
-                                       const abi_type* type, bool) {
-    bool present;
-    from_bin(present, state.bin);
-    if (present)
-        return bin_to_json(state, allow_extensions, type->optional_of(), true);
-    state.writer.write("null", 4);
+template <typename State>
+inline void bin_to_json(pseudo_extension*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_json(state, type, allow_extensions, [] {});
 }
 
-inline void bin_to_json(pseudo_extension*, bin_to_json_state& state, bool allow_extensions,
-                                       const abi_type* type, bool) {
-    bin_to_json(state, allow_extensions, type->extension_of(), true);
+template <typename State>
+inline void bin_to_json(pseudo_object*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_json(state, type, allow_extensions, [] {});
 }
 
-inline void bin_to_json(pseudo_object*, bin_to_json_state& state, bool allow_extensions,
-                                       const abi_type* type, bool start) {
-    if (start) {
-        if (trace_bin_to_json)
-            printf("%*s{ %d fields\n", int(state.stack.size() * 4), "", int(type->as_struct()->fields.size()));
-        state.stack.push_back({type, allow_extensions});
-        state.writer.write('{');
-        return;
+template <typename State>
+inline void bin_to_json(pseudo_array*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_json(state, type, allow_extensions, [] {});
+}
+
+template <typename State>
+inline void bin_to_json(pseudo_variant*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_json(state, type, allow_extensions, [] {});
+}
+
+template <typename T, typename State>
+auto bin_to_json(T* t, State& state, bool, const abi_type*)
+    -> std::void_t<decltype(from_bin(*t, state.bin)), decltype(to_json(*t, state.writer))> {
+    T v;
+    from_bin(v, state.bin);
+    return to_json(v, state.writer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bin_to_binary
+///////////////////////////////////////////////////////////////////////////////
+
+// Converts a builtin. Booleans, integers up to 64 bits, floats and strings (see above) have their own kinds of
+// values; the others are strings holding the text of their json.
+template <typename T, typename State>
+auto bin_to_binary(T* t, State& state, bool, const abi_type*)
+    -> std::void_t<decltype(from_bin(*t, state.bin))> {
+    T v;
+    from_bin(v, state.bin);
+    auto& writer = state.writer;
+    if constexpr (std::is_same_v<T, bool>) {
+        writer.boolean(v);
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) <= 8) {
+        if constexpr (std::is_signed_v<T>)
+            writer.sint(v);
+        else
+            writer.uint(v);
+    } else if constexpr (std::is_same_v<T, varuint32>) {
+        writer.uint(v.value);
+    } else if constexpr (std::is_same_v<T, varint32>) {
+        writer.sint(v.value);
+    } else if constexpr (std::is_same_v<T, float>) {
+        writer.f32(v);
+    } else if constexpr (std::is_same_v<T, double>) {
+        writer.f64(v);
+    } else {
+        char buffer[256];
+        eosio::bounded_buf_stream text{buffer, sizeof(buffer)};
+        to_json(v, text);
+        std::string_view json{buffer, text.size};
+        std::vector<char> large;
+        if (text.size > sizeof(buffer)) {
+            eosio::vector_stream stream{large};
+            to_json(v, stream);
+            json = {large.data(), large.size()};
+        }
+        if (json.size() >= 2 && json.front() == '"' && json.back() == '"')
+            json = json.substr(1, json.size() - 2);
+        writer.str(json);
     }
-    auto& stack_entry = state.stack.back();
-    const std::vector<eosio::abi_field>& fields = type->as_struct()->fields;
-    if (++stack_entry.position < (ptrdiff_t)fields.size()) {
-        auto& field = fields[stack_entry.position];
-        if (trace_bin_to_json)
-            printf("%*sfield %d/%d: %s\n", int(state.stack.size() * 4), "", int(stack_entry.position),
-                   int(fields.size()), std::string{field.name}.c_str());
-        if (state.bin.pos == state.bin.end && field.type->extension_of() && allow_extensions) {
-            state.skipped_extension = true;
-            return;
+}
+
+template <typename State>
+void bin_to_binary(bytes*, State& state, bool, const abi_type*) {
+    uint64_t size;
+    varuint64_from_bin(size, state.bin);
+    const char* data;
+    state.bin.read_reuse_storage(data, size);
+    state.writer.bin(data, size);
+}
+
+template <typename State>
+void bin_to_binary(std::string*, State& state, bool, const abi_type*) {
+    uint32_t size;
+    varuint32_from_bin(size, state.bin);
+    const char* data;
+    state.bin.read_reuse_storage(data, size);
+    state.writer.str({data, size});
+}
+
+// Converts a value of type with the writer of state. Objects are maps from field names to values, variants are
+// arrays of the alternative's name and value, and omitted extensions are left out of their objects, as in json.
+template<typename State, typename F>
+void run_bin_to_binary(State& state, const abi_type* type, bool allow_extensions, F&& f) {
+    using eosio::abi_op;
+    auto& writer = state.writer;
+    program_stack stack;
+    // The header position and size of each open object
+    std::vector<std::pair<size_t, uint32_t>> maps;
+    stack.push(type, allow_extensions);
+    while (!stack.frames.empty()) {
+        f();
+        auto& frame = stack.frames.back();
+        if (frame.pc == frame.end) {
+            stack.frames.pop_back();
+            continue;
+        }
+        auto& op = *frame.pc;
+        bool allow_extensions = frame.allow_extensions && op.allow;
+        switch (op.code) {
+        case abi_op::builtin:
+            op.type->ser->bin_to_binary(state, allow_extensions, op.type);
+            ++frame.pc;
+            break;
+        case abi_op::call:
+            ++frame.pc;
+            stack.push(op.type, allow_extensions);
+            break;
+        case abi_op::begin_object:
+            stack.enter();
+            maps.push_back({writer.begin_map(op.type->as_struct()->fields.size()), 0});
+            ++frame.pc;
+            break;
+        case abi_op::key:
+            if (state.bin.pos == state.bin.end && op.field->type->extension_of() && allow_extensions) {
+                frame.pc += 1 + op.skip;
+                break;
+            }
+            writer.str(op.field->name);
+            ++maps.back().second;
+            ++frame.pc;
+            break;
+        case abi_op::fixed:
+            for (auto* field = op.field; field != op.field + op.count; ++field) {
+                writer.str(field->name);
+                field->type->ser->bin_to_binary(state, false, field->type);
+            }
+            maps.back().second += op.count;
+            ++frame.pc;
+            break;
+        case abi_op::end_object:
+            --stack.depth;
+            writer.end_map(maps.back().first, maps.back().second);
+            maps.pop_back();
+            ++frame.pc;
+            break;
+        case abi_op::optional: {
+            bool present;
+            from_bin(present, state.bin);
+            if (present) {
+                ++frame.pc;
+            } else {
+                writer.nil();
+                frame.pc += 1 + op.skip;
+            }
+            break;
+        }
+        case abi_op::array:
+            if (op.first) {
+                auto* t = op.type->array_of();
+                uint32_t size;
+                varuint32_from_bin(size, state.bin);
+                state.bin.check_available(uint64_t(size) * op.size);
+                writer.array(size);
+                for (uint32_t i = 0; i < size; ++i) {
+                    if (auto* s = t->as_struct()) {
+                        auto map = writer.begin_map(s->fields.size());
+                        for (auto& field : s->fields) {
+                            writer.str(field.name);
+                            field.type->ser->bin_to_binary(state, false, field.type);
+                        }
+                        writer.end_map(map, s->fields.size());
+                    } else {
+                        t->ser->bin_to_binary(state, false, t);
+                    }
+                }
+                ++frame.pc;
+            } else if (!frame.started) {
+                stack.enter();
+                frame.started = true;
+                varuint32_from_bin(frame.count, state.bin);
+                writer.array(frame.count);
+            } else if (frame.index < frame.count) {
+                ++frame.index;
+                stack.push(op.type->array_of(), false);
+            } else {
+                --stack.depth;
+                ++frame.pc;
+            }
+            break;
+        case abi_op::variant:
+            if (!frame.started) {
+                stack.enter();
+                frame.started = true;
+                uint32_t index;
+                varuint32_from_bin(index, state.bin);
+                const std::vector<eosio::abi_field>& fields = *op.type->as_variant();
+                EOS_CHECK(index < fields.size(), std::string(eosio::convert_stream_error(eosio::stream_error::bad_variant_index)) + " of type " + op.type->name);
+                auto& field = fields[index];
+                writer.array(2);
+                writer.str(field.name);
+                stack.push(field.type, allow_extensions);
+            } else {
+                --stack.depth;
+                ++frame.pc;
+            }
+            break;
         }
-        if(stack_entry.position != 0) { state.writer.write(','); };
-        to_json(field.name, state.writer);
-        state.writer.write(':');
-        bin_to_json(state, allow_extensions && &field == &fields.back(), field.type, true);
-    } else {
-        if (trace_bin_to_json)
-            printf("%*s}\n", int((state.stack.size() - 1) * 4), "");
-        state.stack.pop_back();
-        state.writer.write('}');
     }
 }
 
-inline void bin_to_json(pseudo_array*, bin_to_json_state& state, bool, const abi_type* type,
-                                         bool start) {
-    if (start) {
-        state.stack.push_back({type, false});
-        varuint32_from_bin(state.stack.back().array_size, state.bin);
-        if (trace_bin_to_json)
-            printf("%*s[ %d items\n", int(state.stack.size() * 4), "", int(state.stack.back().array_size));
-        return state.writer.write('[');
+// Composite types met outside of a program, such as a struct too deep to be inlined, run their own
+template <typename State>
+void bin_to_binary(pseudo_optional*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_binary(state, type, allow_extensions, [] {});
+}
+
+template <typename State>
+void bin_to_binary(pseudo_extension*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_binary(state, type, allow_extensions, [] {});
+}
+
+template <typename State>
+void bin_to_binary(pseudo_object*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_binary(state, type, allow_extensions, [] {});
+}
+
+template <typename State>
+void bin_to_binary(pseudo_array*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_binary(state, type, allow_extensions, [] {});
+}
+
+template <typename State>
+void bin_to_binary(pseudo_variant*, State& state, bool allow_extensions, const abi_type* type) {
+    run_bin_to_binary(state, type, allow_extensions, [] {});
+}
+
+template<typename Writer, typename F>
+inline void bin_to_binary(eosio::input_stream& bin, const abi_type* type, std::vector<char>& dest, F&& f) {
+    basic_bin_to_binary_state<Writer> state{bin, Writer{dest}};
+    run_bin_to_binary(state, type, true, f);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// skip_bin
+///////////////////////////////////////////////////////////////////////////////
+
+// The size in binary of a struct made only of fixed-size builtins, or 0 if it is not one
+inline uint32_t fixed_layout(const abi_type* type) {
+    auto* s = type->as_struct();
+    if (!s || s->fields.empty())
+        return 0;
+    uint32_t size = 0;
+    for (auto& field : s->fields) {
+        if (!field.type->fixed_size)
+            return 0;
+        size += field.type->fixed_size;
     }
-    auto& stack_entry = state.stack.back();
-    if (++stack_entry.position < (ptrdiff_t)stack_entry.array_size) {
-        if (trace_bin_to_json)
-            printf("%*sitem %d/%d %p %s\n", int(state.stack.size() * 4), "", int(stack_entry.position),
-                   int(stack_entry.array_size), type->array_of()->ser, type->array_of()->name.c_str());
-        if (stack_entry.position != 0) { state.writer.write(','); }
-        return bin_to_json(state, false, type->array_of(), true);
-    } else {
-        if (trace_bin_to_json)
-            printf("%*s]\n", int((state.stack.size()) * 4), "");
-        state.stack.pop_back();
-        return state.writer.write(']');
+    return size;
+}
+
+// Steps over fixed-size builtins without calling their serializer
+inline void skip_bin(eosio::input_stream& bin, bool allow_extensions, const abi_type* type, size_t depth) {
+    if (type->fixed_size)
+        return bin.skip(type->fixed_size);
+    type->ser->skip_bin(bin, allow_extensions, type, depth);
+}
+
+// Reads the rest of the builtins: varuint32 and varint32
+template <typename T>
+auto skip_bin(T* t, eosio::input_stream& bin, bool, const abi_type*, size_t)
+    -> std::void_t<decltype(from_bin(*t, bin))> {
+    T v;
+    from_bin(v, bin);
+}
+
+inline void skip_bin(std::string*, eosio::input_stream& bin, bool, const abi_type*, size_t) {
+    uint32_t size;
+    varuint32_from_bin(size, bin);
+    bin.skip(size);
+}
+
+inline void skip_bin(bytes*, eosio::input_stream& bin, bool, const abi_type*, size_t) {
+    uint64_t size;
+    varuint64_from_bin(size, bin);
+    bin.skip(size);
+}
+
+// The ecc key, then for webauthn keys the user presence and the rpid
+inline void skip_bin(public_key*, eosio::input_stream& bin, bool, const abi_type* type, size_t depth) {
+    uint32_t index;
+    varuint32_from_bin(index, bin);
+    EOS_CHECK(index < std::variant_size_v<public_key>, std::string(eosio::convert_stream_error(eosio::stream_error::bad_variant_index)) + " of type " + type->name);
+    bin.skip(sizeof(eosio::ecc_public_key));
+    if (index == 2) {
+        bin.skip(sizeof(eosio::webauthn_public_key::user_presence_t));
+        skip_bin((std::string*)nullptr, bin, false, type, depth);
     }
 }
 
-inline void bin_to_json(pseudo_variant*, bin_to_json_state& state, bool allow_extensions,
-                                         const abi_type* type, bool start) {
-    if (start) {
-        state.stack.push_back({type, allow_extensions});
-        if (trace_bin_to_json)
-            printf("%*s[ variant\n", int(state.stack.size() * 4), "");
-        return state.writer.write('[');
+inline void skip_bin(private_key*, eosio::input_stream& bin, bool, const abi_type* type, size_t) {
+    uint32_t index;
+    varuint32_from_bin(index, bin);
+    EOS_CHECK(index < std::variant_size_v<private_key>, std::string(eosio::convert_stream_error(eosio::stream_error::bad_variant_index)) + " of type " + type->name);
+    bin.skip(sizeof(eosio::ecc_private_key));
+}
+
+// The compact signature, then for webauthn signatures the authenticator data and the client json
+inline void skip_bin(signature*, eosio::input_stream& bin, bool, const abi_type* type, size_t depth) {
+    uint32_t index;
+    varuint32_from_bin(index, bin);
+    EOS_CHECK(index < std::variant_size_v<signature>, std::string(eosio::convert_stream_error(eosio::stream_error::bad_variant_index)) + " of type " + type->name);
+    bin.skip(sizeof(eosio::ecc_signature));
+    if (index == 2) {
+        skip_bin((bytes*)nullptr, bin, false, type, depth);
+        skip_bin((std::string*)nullptr, bin, false, type, depth);
     }
-    auto& stack_entry = state.stack.back();
-    if (++stack_entry.position == 0) {
-        uint32_t index;
-        varuint32_from_bin(index, state.bin);
-        const std::vector<eosio::abi_field>& fields = *stack_entry.type->as_variant();
-        EOS_CHECK(index < fields.size(), std::string(eosio::convert_stream_error(eosio::stream_error::bad_variant_index)) + " of type " + type->name);
-        auto& f = fields[index];
-        to_json(f.name, state.writer);
-        state.writer.write(',');
-        // FIXME: allow_extensions should be stack_entry.allow_extensions, so why are we combining them?
-        bin_to_json(state, allow_extensions && stack_entry.allow_extensions, f.type, true);
+}
+
+// Keys and signatures are converted in place from their binary form to their text, which is written to buffer
+// unless it's a webauthn value too long for it
+template <typename T>
+std::string_view key_bin_to_text(T* t, eosio::input_stream& bin, const abi_type* type, char (&buffer)[256],
+                                 std::string& large) {
+    auto* begin = bin.pos;
+    skip_bin(t, bin, false, type, 0);
+    std::string_view data{begin, size_t(bin.pos - begin)};
+    auto to_string = [&](char* dest, size_t size) {
+        if constexpr (std::is_same_v<T, public_key>)
+            return eosio::public_key_bin_to_string(data, dest, size);
+        else if constexpr (std::is_same_v<T, private_key>)
+            return eosio::private_key_bin_to_string(data, dest, size);
+        else
+            return eosio::signature_bin_to_string(data, dest, size);
+    };
+    if (auto size = to_string(buffer, sizeof(buffer)))
+        return {buffer, size};
+    // A 7-char prefix, then at most 138 base58 digits for each 100 bytes of the value and its checksum
+    large.resize(7 + (data.size() + 4) * 138 / 100 + 1);
+    large.resize(to_string(large.data(), large.size()));
+    return large;
+}
+
+template <typename T, typename State>
+void key_bin_to_json(T* t, State& state, const abi_type* type) {
+    char buffer[256];
+    std::string large;
+    to_json(key_bin_to_text(t, state.bin, type, buffer, large), state.writer);
+}
+
+template <typename T, typename State>
+void key_bin_to_binary(T* t, State& state, const abi_type* type) {
+    char buffer[256];
+    std::string large;
+    state.writer.str(key_bin_to_text(t, state.bin, type, buffer, large));
+}
+
+template <typename State>
+void bin_to_json(public_key* t, State& state, bool, const abi_type* type) {
+    key_bin_to_json(t, state, type);
+}
+
+template <typename State>
+void bin_to_json(private_key* t, State& state, bool, const abi_type* type) {
+    key_bin_to_json(t, state, type);
+}
+
+template <typename State>
+void bin_to_json(signature* t, State& state, bool, const abi_type* type) {
+    key_bin_to_json(t, state, type);
+}
+
+template <typename State>
+void bin_to_binary(public_key* t, State& state, bool, const abi_type* type) {
+    key_bin_to_binary(t, state, type);
+}
+
+template <typename State>
+void bin_to_binary(private_key* t, State& state, bool, const abi_type* type) {
+    key_bin_to_binary(t, state, type);
+}
+
+template <typename State>
+void bin_to_binary(signature* t, State& state, bool, const abi_type* type) {
+    key_bin_to_binary(t, state, type);
+}
+
+template <typename State>
+void json_to_bin(public_key*, State& state, bool, const abi_type*, bool) {
+    eosio::public_key_string_to_bin(state.get_string(), state.writer.data);
+}
+
+template <typename State>
+void json_to_bin(private_key*, State& state, bool, const abi_type*, bool) {
+    eosio::private_key_string_to_bin(state.get_string(), state.writer.data);
+}
+
+template <typename State>
+void json_to_bin(signature*, State& state, bool, const abi_type*, bool) {
+    eosio::signature_string_to_bin(state.get_string(), state.writer.data);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// array kernels
+///////////////////////////////////////////////////////////////////////////////
+
+// Converts the size elements of an array of T in one loop. Numbers, names and checksums are read straight from
+// the input, whose size the caller has checked for the whole array.
+template <typename T, typename State>
+void array_bin_to_json(T* t, State& state, const abi_type* type, uint32_t size) {
+    auto& writer = state.writer;
+    const char* pos = state.bin.pos;
+    if constexpr ((std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_floating_point_v<T>) {
+        for (uint32_t i = 0; i < size; ++i, pos += sizeof(T)) {
+            if (i)
+                writer.write(',');
+            T v;
+            memcpy(&v, pos, sizeof(T));
+            to_json(v, writer);
+        }
+        state.bin.pos = pos;
+    } else if constexpr (std::is_same_v<T, name>) {
+        // Names only have characters which json strings take as they are
+        char buffer[eosio::max_name_chars + 3];
+        for (uint32_t i = 0; i < size; ++i, pos += sizeof(uint64_t)) {
+            uint64_t v;
+            memcpy(&v, pos, sizeof(v));
+            buffer[0] = ',';
+            buffer[1] = '"';
+            char* end = eosio::name_to_chars(v, buffer + 2);
+            *end++ = '"';
+            writer.write(buffer + !i, end - buffer - !i);
+        }
+        state.bin.pos = pos;
+    } else if constexpr (std::is_same_v<T, checksum160> || std::is_same_v<T, checksum256> ||
+                         std::is_same_v<T, checksum512>) {
+        for (uint32_t i = 0; i < size; ++i, pos += type->fixed_size) {
+            if (i)
+                writer.write(',');
+            to_json_hex(pos, type->fixed_size, writer);
+        }
+        state.bin.pos = pos;
     } else {
-        if (trace_bin_to_json)
-            printf("%*s]\n", int((state.stack.size()) * 4), "");
-        state.stack.pop_back();
-        state.writer.write(']');
+        for (uint32_t i = 0; i < size; ++i) {
+            if (i)
+                writer.write(',');
+            bin_to_json(t, state, false, type);
+        }
     }
 }
 
-template <typename T>
-auto bin_to_json(T* t, bin_to_json_state& state, bool, const abi_type*, bool start)
-    -> std::void_t<decltype(from_bin(*t, state.bin)), decltype(to_json(*t, state.writer))> {
-    T v;
-    from_bin(v, state.bin);
-    return to_json(v, state.writer);
+// Reads elements of an array of T up to the end of the array and returns their count
+template <typename T, typename State>
+uint32_t array_json_to_bin(T* t, State& state, const abi_type* type) {
+    uint32_t size = 0;
+    for (; !state.get_end_array_pred(); ++size)
+        json_to_bin(t, state, false, type, true);
+    return size;
+}
+
+inline void skip_bin(pseudo_optional*, eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                     size_t depth) {
+    bool present;
+    from_bin(present, bin);
+    if (present)
+        skip_bin(bin, allow_extensions, type->optional_of(), depth);
+}
+
+inline void skip_bin(pseudo_extension*, eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                     size_t depth) {
+    skip_bin(bin, allow_extensions, type->extension_of(), depth);
+}
+
+inline void skip_bin(pseudo_object*, eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                     size_t depth) {
+    eosio::check(depth < max_stack_size, eosio::convert_abi_error(eosio::abi_error::recursion_limit_reached));
+    auto& fields = type->as_struct()->fields;
+    for (auto& field : fields) {
+        if (bin.pos == bin.end && field.type->extension_of() && allow_extensions)
+            continue;
+        skip_bin(bin, allow_extensions && &field == &fields.back(), field.type, depth + 1);
+    }
+}
+
+inline void skip_bin(pseudo_array*, eosio::input_stream& bin, bool, const abi_type* type, size_t depth) {
+    eosio::check(depth < max_stack_size, eosio::convert_abi_error(eosio::abi_error::recursion_limit_reached));
+    auto* element = type->array_of();
+    uint32_t size;
+    varuint32_from_bin(size, bin);
+    if (auto fixed = element->is_builtin() ? element->fixed_size : fixed_layout(element))
+        return bin.skip(uint64_t(size) * fixed);
+    for (uint32_t i = 0; i < size; ++i)
+        skip_bin(bin, false, element, depth + 1);
+}
+
+inline void skip_bin(pseudo_variant*, eosio::input_stream& bin, bool allow_extensions, const abi_type* type,
+                     size_t depth) {
+    eosio::check(depth < max_stack_size, eosio::convert_abi_error(eosio::abi_error::recursion_limit_reached));
+    uint32_t index;
+    varuint32_from_bin(index, bin);
+    const std::vector<eosio::abi_field>& fields = *type->as_variant();
+    EOS_CHECK(index < fields.size(), std::string(eosio::convert_stream_error(eosio::stream_error::bad_variant_index)) + " of type " + type->name);
+    skip_bin(bin, allow_extensions, fields[index].type, depth + 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// projections
+///////////////////////////////////////////////////////////////////////////////
+
+// Appends the json of the fields node n selects, skipping the rest of the value
+template<typename Writer, typename F>
+void projection_to_json(eosio::input_stream& bin, const eosio::abi_projection& projection, uint32_t n,
+                        bool allow_extensions, Writer& writer, F&& f, size_t depth = 0) {
+    auto& node = projection.nodes[n];
+    auto* type = node.type;
+    if (node.whole)
+        return bin_to_json(bin, type, writer, f, allow_extensions);
+    f();
+    eosio::check(depth < max_stack_size, eosio::convert_abi_error(eosio::abi_error::recursion_limit_reached));
+    if (type->optional_of()) {
+        bool present;
+        from_bin(present, bin);
+        if (!present)
+            return writer.write("null", 4);
+        return projection_to_json(bin, projection, node.inner, allow_extensions, writer, f, depth + 1);
+    }
+    if (type->extension_of())
+        return projection_to_json(bin, projection, node.inner, allow_extensions, writer, f, depth + 1);
+    if (auto* s = type->as_struct()) {
+        writer.write('{');
+        auto selected = node.fields.begin();
+        bool first = true;
+        for (uint32_t i = 0; i < s->fields.size(); ++i) {
+            auto& field = s->fields[i];
+            bool allow = allow_extensions && i + 1 == s->fields.size();
+            if (bin.pos == bin.end && field.type->extension_of() && allow_extensions)
+                continue;
+            if (selected == node.fields.end() || selected->first != i) {
+                skip_bin(bin, allow, field.type, depth + 1);
+                continue;
+            }
+            if (!first)
+                writer.write(',');
+            first = false;
+            write_key(field, writer);
+            projection_to_json(bin, projection, selected->second, allow, writer, f, depth + 1);
+            ++selected;
+        }
+        return writer.write('}');
+    }
+    if (type->array_of()) {
+        uint32_t size;
+        varuint32_from_bin(size, bin);
+        writer.write('[');
+        for (uint32_t i = 0; i < size; ++i) {
+            if (i)
+                writer.write(',');
+            projection_to_json(bin, projection, node.inner, false, writer, f, depth + 1);
+        }
+        return writer.write(']');
+    }
+    auto& alternatives = *type->as_variant();
+    uint32_t index;
+    varuint32_from_bin(index, bin);
+    EOS_CHECK(index < alternatives.size(), std::string(eosio::convert_stream_error(eosio::stream_error::bad_variant_index)) + " of type " + type->name);
+    auto& alternative = alternatives[index];
+    writer.write('[');
+    write_alternative(alternative, writer);
+    writer.write(',');
+    if (node.alternatives[index]) {
+        projection_to_json(bin, projection, node.alternatives[index], allow_extensions, writer, f, depth + 1);
+    } else {
+        skip_bin(bin, allow_extensions, alternative.type, depth + 1);
+        writer.write("null", 4);
+    }
+    writer.write(']');
 }
 
 } // namespace abieos
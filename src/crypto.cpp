@@ -83,6 +83,43 @@ std::string binary_to_base58(const Container& bin) {
     return result;
 }
 
+// Writes the base58 digits of a followed by b to dest; returns their count, or 0 if more than size are needed
+std::size_t binary_to_base58(std::string_view a, std::string_view b, char* dest, std::size_t size) {
+    std::size_t n = 0;
+    auto add = [&](uint8_t byte) {
+        int carry = byte;
+        for (std::size_t i = 0; i < n; ++i) {
+            int x = (dest[i] << 8) + carry;
+            dest[i] = x % 58;
+            carry = x / 58;
+        }
+        while (carry) {
+            if (n == size)
+                return false;
+            dest[n++] = carry % 58;
+            carry = carry / 58;
+        }
+        return true;
+    };
+    for (auto part : {a, b})
+        for (auto byte : part)
+            if (!add(byte))
+                return 0;
+    bool leading = true;
+    for (auto part : {a, b})
+        for (auto byte : part) {
+            if (!(leading = leading && !byte))
+                break;
+            if (n == size)
+                return 0;
+            dest[n++] = 0;
+        }
+    std::reverse(dest, dest + n);
+    for (std::size_t i = 0; i < n; ++i)
+        dest[i] = base58_chars[static_cast<uint8_t>(dest[i])];
+    return n;
+}
+
 template <typename... Container>
 std::array<unsigned char, 20> digest_suffix_ripemd160(const Container&... data) {
     std::array<unsigned char, 20> digest;
@@ -94,114 +131,192 @@ std::array<unsigned char, 20> digest_suffix_ripemd160(const Container&... data)
     return digest;
 }
 
+// Size of the binary Key at the start of bin
+template <typename Key>
+std::size_t key_bin_size(std::string_view bin) {
+    input_stream stream{bin.data(), bin.size()};
+    uint32_t index;
+    varuint32_from_bin(index, stream);
+    auto skip_sized = [&] {
+        uint32_t size;
+        varuint32_from_bin(size, stream);
+        stream.skip(size);
+    };
+    if constexpr (std::is_same_v<Key, public_key>) {
+        stream.skip(sizeof(ecc_public_key));
+        if (index == key_type::wa) {
+            stream.skip(sizeof(webauthn_public_key::user_presence_t));
+            skip_sized();
+        }
+    } else if constexpr (std::is_same_v<Key, private_key>) {
+        stream.skip(sizeof(ecc_private_key));
+    } else {
+        stream.skip(sizeof(ecc_signature));
+        if (index == key_type::wa) {
+            skip_sized();
+            skip_sized();
+        }
+    }
+    return stream.pos - bin.data();
+}
 
+// Appends the key type and then the key decoded from s, whose checksum is checked and dropped. Anything
+// decoded past the end of the Key is dropped too.
 template <typename Key>
-Key string_to_key(std::string_view s, key_type type, std::string_view suffix) {
-    std::vector<char> whole;
-    whole.push_back(uint8_t{type});
-    base58_to_binary(whole, s);
-    check(whole.size() > 5,
+void string_to_key_bin(std::vector<char>& dest, std::string_view s, key_type type, std::string_view suffix) {
+    auto offset = dest.size();
+    dest.push_back(uint8_t{type});
+    base58_to_binary(dest, s);
+    check(dest.size() - offset > 5,
         convert_json_error(eosio::from_json_error::expected_key));
-    auto ripe_digest = digest_suffix_ripemd160(std::string_view(whole.data() + 1, whole.size() - 5), suffix);
-    check(memcmp(ripe_digest.data(), whole.data() + whole.size() - 4, 4)==0,
+    auto ripe_digest = digest_suffix_ripemd160(std::string_view(dest.data() + offset + 1, dest.size() - offset - 5), suffix);
+    check(memcmp(ripe_digest.data(), dest.data() + dest.size() - 4, 4)==0,
         convert_json_error(from_json_error::expected_key));
-    whole.erase(whole.end() - 4, whole.end());
-    return convert_from_bin<Key>(whole);
+    dest.resize(dest.size() - 4);
+    dest.resize(offset + key_bin_size<Key>(std::string_view(dest.data() + offset, dest.size() - offset)));
 }
 
-template <typename Key>
-std::string key_to_string(const Key& key, std::string_view suffix, const char* prefix) {
+std::size_t key_bin_to_string(std::string_view bin, std::string_view suffix, std::string_view prefix, char* dest,
+                              std::size_t size) {
+    if (size < prefix.size())
+        return 0;
+    auto data = bin.substr(1);
+    auto ripe_digest = digest_suffix_ripemd160(data, suffix);
+    auto n = binary_to_base58(data, std::string_view((const char*)ripe_digest.data(), 4), dest + prefix.size(),
+                              size - prefix.size());
+    if (!n)
+        return 0;
+    memcpy(dest, prefix.data(), prefix.size());
+    return prefix.size() + n;
+}
+
+template <typename Key, typename F>
+std::string key_to_string(const Key& key, F bin_to_string) {
     auto whole = convert_to_bin(key);
-    auto ripe_digest = digest_suffix_ripemd160(std::string_view(whole.data() + 1, whole.size() - 1), suffix);
-    whole.insert(whole.end(), ripe_digest.data(), ripe_digest.data() + 4);
-    return prefix + binary_to_base58(std::string_view(whole.data() + 1, whole.size() - 1));
+    // 7 prefix chars, then at most 138 base58 digits for each 100 bytes
+    std::string result(7 + (whole.size() + 4) * 138 / 100 + 1, '\0');
+    result.resize(bin_to_string(std::string_view(whole.data(), whole.size()), result.data(), result.size()));
+    return result;
+}
+
+template <typename Key, typename F>
+Key string_to_key(std::string_view s, F string_to_bin) {
+    std::vector<char> whole;
+    string_to_bin(s, whole);
+    return convert_from_bin<Key>(whole);
 }
 } // namespace
 
-std::string eosio::public_key_to_string(const public_key& key) {
-    if (key.index() == key_type::k1) {
-        return key_to_string(key, "K1", "PUB_K1_");
-    } else if (key.index() == key_type::r1) {
-        return key_to_string(key, "R1", "PUB_R1_");
-    } else if (key.index() == key_type::wa) {
-        return key_to_string(key, "WA", "PUB_WA_");
+std::size_t eosio::public_key_bin_to_string(std::string_view bin, char* dest, std::size_t size) {
+    check(!bin.empty(), convert_json_error(eosio::from_json_error::expected_public_key));
+    if (bin[0] == key_type::k1) {
+        return key_bin_to_string(bin, "K1", "PUB_K1_", dest, size);
+    } else if (bin[0] == key_type::r1) {
+        return key_bin_to_string(bin, "R1", "PUB_R1_", dest, size);
+    } else if (bin[0] == key_type::wa) {
+        return key_bin_to_string(bin, "WA", "PUB_WA_", dest, size);
     } else {
        check(false, convert_json_error(eosio::from_json_error::expected_public_key));
        __builtin_unreachable();
     }
 }
 
-public_key eosio::public_key_from_string(std::string_view s) {
-    public_key result;
+void eosio::public_key_string_to_bin(std::string_view s, std::vector<char>& dest) {
     if (s.substr(0, 3) == "EOS") {
-        return string_to_key<public_key>(s.substr(3), key_type::k1, "");
+        return string_to_key_bin<public_key>(dest, s.substr(3), key_type::k1, "");
     } else if (s.substr(0, 7) == "PUB_K1_") {
-        return string_to_key<public_key>(s.substr(7), key_type::k1, "K1");
+        return string_to_key_bin<public_key>(dest, s.substr(7), key_type::k1, "K1");
     } else if (s.substr(0, 7) == "PUB_R1_") {
-        return string_to_key<public_key>(s.substr(7), key_type::r1, "R1");
+        return string_to_key_bin<public_key>(dest, s.substr(7), key_type::r1, "R1");
     } else if (s.substr(0, 7) == "PUB_WA_") {
-        return string_to_key<public_key>(s.substr(7), key_type::wa, "WA");
+        return string_to_key_bin<public_key>(dest, s.substr(7), key_type::wa, "WA");
     } else {
        check(false, convert_json_error(from_json_error::expected_public_key));
        __builtin_unreachable();
     }
 }
 
-std::string eosio::private_key_to_string(const private_key& private_key) {
-    if (private_key.index() == key_type::k1)
-        return key_to_string(private_key, "K1", "PVT_K1_");
-    else if (private_key.index() == key_type::r1)
-        return key_to_string(private_key, "R1", "PVT_R1_");
+std::string eosio::public_key_to_string(const public_key& key) {
+    return key_to_string(key, public_key_bin_to_string);
+}
+
+public_key eosio::public_key_from_string(std::string_view s) {
+    return string_to_key<public_key>(s, public_key_string_to_bin);
+}
+
+std::size_t eosio::private_key_bin_to_string(std::string_view bin, char* dest, std::size_t size) {
+    check(!bin.empty(), convert_json_error(from_json_error::expected_private_key));
+    if (bin[0] == key_type::k1)
+        return key_bin_to_string(bin, "K1", "PVT_K1_", dest, size);
+    else if (bin[0] == key_type::r1)
+        return key_bin_to_string(bin, "R1", "PVT_R1_", dest, size);
     else {
        check(false, convert_json_error(from_json_error::expected_private_key));
        __builtin_unreachable();
     }
 }
 
-private_key eosio::private_key_from_string(std::string_view s) {
+void eosio::private_key_string_to_bin(std::string_view s, std::vector<char>& dest) {
     if (s.substr(0, 7) == "PVT_K1_")
-        return string_to_key<private_key>(s.substr(7), key_type::k1, "K1");
+        return string_to_key_bin<private_key>(dest, s.substr(7), key_type::k1, "K1");
     else if (s.substr(0, 7) == "PVT_R1_")
-        return string_to_key<private_key>(s.substr(7), key_type::r1, "R1");
+        return string_to_key_bin<private_key>(dest, s.substr(7), key_type::r1, "R1");
     else if (s.substr(0, 4) == "PVT_") {
        check(false, convert_json_error(from_json_error::expected_private_key));
        __builtin_unreachable();
     } else {
-        std::vector<char> whole;
-        base58_to_binary(whole, s);
-        check(whole.size() >= 5, convert_json_error(from_json_error::expected_private_key));
-        whole[0] = key_type::k1;
-        whole.erase(whole.end() - 4, whole.end());
-        return convert_from_bin<private_key>(whole);
+        auto offset = dest.size();
+        base58_to_binary(dest, s);
+        check(dest.size() - offset >= 5, convert_json_error(from_json_error::expected_private_key));
+        dest[offset] = key_type::k1;
+        dest.resize(dest.size() - 4);
+        dest.resize(offset + key_bin_size<private_key>(std::string_view(dest.data() + offset, dest.size() - offset)));
     }
 }
 
-std::string eosio::signature_to_string(const eosio::signature& signature) {
-    if (signature.index() == key_type::k1)
-        return key_to_string(signature, "K1", "SIG_K1_");
-    else if (signature.index() == key_type::r1)
-        return key_to_string(signature, "R1", "SIG_R1_");
-    else if (signature.index() == key_type::wa)
-        return key_to_string(signature, "WA", "SIG_WA_");
+std::string eosio::private_key_to_string(const private_key& private_key) {
+    return key_to_string(private_key, private_key_bin_to_string);
+}
+
+private_key eosio::private_key_from_string(std::string_view s) {
+    return string_to_key<private_key>(s, private_key_string_to_bin);
+}
+
+std::size_t eosio::signature_bin_to_string(std::string_view bin, char* dest, std::size_t size) {
+    check(!bin.empty(), convert_json_error(eosio::from_json_error::expected_signature));
+    if (bin[0] == key_type::k1)
+        return key_bin_to_string(bin, "K1", "SIG_K1_", dest, size);
+    else if (bin[0] == key_type::r1)
+        return key_bin_to_string(bin, "R1", "SIG_R1_", dest, size);
+    else if (bin[0] == key_type::wa)
+        return key_bin_to_string(bin, "WA", "SIG_WA_", dest, size);
     else {
        check(false, convert_json_error(eosio::from_json_error::expected_signature));
        __builtin_unreachable();
     }
 }
 
-signature eosio::signature_from_string(std::string_view s) {
+void eosio::signature_string_to_bin(std::string_view s, std::vector<char>& dest) {
     if (s.size() >= 7 && s.substr(0, 7) == "SIG_K1_")
-        return string_to_key<signature>(s.substr(7), key_type::k1, "K1");
+        return string_to_key_bin<signature>(dest, s.substr(7), key_type::k1, "K1");
     else if (s.size() >= 7 && s.substr(0, 7) == "SIG_R1_")
-        return string_to_key<signature>(s.substr(7), key_type::r1, "R1");
+        return string_to_key_bin<signature>(dest, s.substr(7), key_type::r1, "R1");
     else if (s.size() >= 7 && s.substr(0, 7) == "SIG_WA_")
-        return string_to_key<signature>(s.substr(7), key_type::wa, "WA");
+        return string_to_key_bin<signature>(dest, s.substr(7), key_type::wa, "WA");
     else {
        check(false, convert_json_error(eosio::from_json_error::expected_signature));
        __builtin_unreachable();
     }
 }
 
+std::string eosio::signature_to_string(const eosio::signature& signature) {
+    return key_to_string(signature, signature_bin_to_string);
+}
+
+signature eosio::signature_from_string(std::string_view s) {
+    return string_to_key<signature>(s, signature_string_to_bin);
+}
+
 namespace eosio {
     std::string to_base58(const char* d, size_t s ) {
         return binary_to_base58( std::string_view(d,s) );
@@ -6,9 +6,13 @@
 #include "rapidjson/document.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
 #include <stdio.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 extern const char* const state_history_plugin_abi;
@@ -539,6 +543,11 @@ void run_check_type(abieos_context* context, uint64_t contract, const char* type
         expected = data;
     // printf("%s %s\n", type, data);
     check_context(context, abieos_json_to_bin_reorderable(context, contract, type, data));
+    size_t value_size = 0;
+    check_context(context, abieos_bin_size(context, check_context(context, abieos_resolve_type(context, contract, type)),
+                                           abieos_get_bin_data(context), abieos_get_bin_size(context), &value_size));
+    if (value_size != size_t(abieos_get_bin_size(context)))
+        throw std::runtime_error("mismatch between abieos_bin_size, binary size");
     std::string reorderable_hex = check_context(context, abieos_get_bin_hex(context));
     if (check_ordered) {
         check_context(context, abieos_json_to_bin(context, contract, type, data));
@@ -694,6 +703,14 @@ void check_types() {
     check_type(context, 0, "uint8[]", R"([10])");
     check_type(context, 0, "uint8[]", R"([10,9])");
     check_type(context, 0, "uint8[]", R"([10,9,8])");
+    check_type(context, 0, "uint8[]", R"([0,255,128,7])");
+    check_error(context, "Stream overrun", [&] { return abieos_hex_to_json(context, 0, "uint8[]", "030102"); });
+    check_type(context, 0, "int64[]", R"(["-1","9223372036854775807","0"])");
+    check_error(context, "Stream overrun", [&] { return abieos_hex_to_json(context, 0, "uint16[]", "020100FF"); });
+    check_type(context, 0, "float64[]", R"([1.5,-0.25,"Infinity"])");
+    check_type(context, 0, "name[]", R"(["eosio","","eosio.token","zzzzzzzzzzzzj"])");
+    check_type(context, 0, "checksum160[]",
+               R"(["0000000000000000000000000000000000000000","123456789ABCDEF01234567890ABCDEF70123456"])");
     check_type(context, 0, "int16", R"(0)");
     check_type(context, 0, "int16", R"(32767)");
     check_type(context, 0, "int16", R"(-32768)");
@@ -838,6 +855,13 @@ void check_types() {
     check_type(context, 0, "bytes", R"("")");
     check_type(context, 0, "bytes", R"("00")");
     check_type(context, 0, "bytes", R"("AABBCCDDEEFF00010203040506070809")");
+    check_type(context, 0, "bytes",
+               R"("00112233445566778899aabbccddeeffFFEEDDCCBBAA99887766554433221100A9f0")",
+               R"("00112233445566778899AABBCCDDEEFFFFEEDDCCBBAA99887766554433221100A9F0")");
+    check_error(context, "expected hex string", [&] {
+        return abieos_json_to_bin(context, 0, "bytes", R"("00112233445566778899AABBCCDDEEFF0011223344556G778899AABBCCDDEEFF")");
+    });
+    check_error(context, "expected hex string", [&] { return abieos_set_abi_hex(context, 8, "0g"); });
     check_error(context, "odd number of hex digits", [&] { return abieos_json_to_bin(context, 0, "bytes", R"("0")"); });
     check_error(context, "expected hex string", [&] { return abieos_json_to_bin(context, 0, "bytes", R"("yz")"); });
     check_error(context, "expected string containing hex digits",
@@ -853,6 +877,13 @@ void check_types() {
           "invalid utf8");
     check(abieos_bin_to_json(context, 0, "string", "\4\xe8\xbf\x99\n", 5) == std::string("\"\xe8\xbf\x99\\u000A\""),
           "escaping");
+    check_type(context, 0, "string",
+               R"("0123456789abcdefghijklmnopqrstuvwxyz\"ABCDEFGHIJKLMNOPQRSTUV\\WXYZ\u007F0123456789abcdefghijklmnop\u001F")");
+    check_type(context, 0, "string",
+               R"("Это тест, and then a run of ascii long enough for a whole vector: 这是一个测试 👍 and more ascii")");
+    check(abieos_bin_to_json(context, 0, "string", "\x23long ascii before invalid utf8: \xff\xe8\xbf", 36) ==
+              std::string(R"("long ascii before invalid utf8: ???")"),
+          "invalid utf8 after a long run");
     check_error(context, "Stream overrun", [&] { return abieos_hex_to_json(context, 0, "string", "01"); });
     check_type(context, 0, "checksum160", R"("0000000000000000000000000000000000000000")");
     check_type(context, 0, "checksum160", R"("123456789ABCDEF01234567890ABCDEF70123456")");
@@ -942,6 +973,8 @@ void check_types() {
                 [&] { return abieos_json_to_bin(context, 0, "signature", "true"); });
     check_error(context, "unrecognized signature format",
                 [&] { return abieos_json_to_bin(context, 0, "signature", R"("foo")"); });
+    check_error(context, "Bad variant index of type signature",
+                [&] { return abieos_hex_to_json(context, 0, "signature", "03"); });
     check_type(context, 0, "symbol_code", R"("A")");
     check_type(context, 0, "symbol_code", R"("B")");
     check_type(context, 0, "symbol_code", R"("SYS")");
@@ -950,6 +983,7 @@ void check_types() {
     check_type(context, 0, "symbol", R"("0,A")");
     check_type(context, 0, "symbol", R"("1,Z")");
     check_type(context, 0, "symbol", R"("4,SYS")");
+    check_type(context, 0, "symbol", R"("255,SYS")");
     check_error(context, "expected string containing symbol",
                 [&] { return abieos_json_to_bin(context, 0, "symbol", "null"); });
     check_type(context, 0, "asset", R"("0 FOO")");
@@ -958,6 +992,7 @@ void check_types() {
     check_type(context, 0, "asset", R"("0.000 FOO")");
     check_type(context, 0, "asset", R"("1.2345 SYS")");
     check_type(context, 0, "asset", R"("-1.2345 SYS")");
+    check_type(context, 0, "asset", R"("-0.000000000000000000000000000012345 MAXCODE")");
     check_error(context, "expected string containing asset",
                 [&] { return abieos_json_to_bin(context, 0, "asset", "null"); });
     check_type(context, 0, "asset[]", R"([])");
@@ -967,6 +1002,20 @@ void check_types() {
     check_type(context, 0, "asset?", R"("0.123456 SIX")");
     check_type(context, 0, "extended_asset", R"({"quantity":"0 FOO","contract":"bar"})");
     check_type(context, 0, "extended_asset", R"({"quantity":"0.123456 SIX","contract":"seven"})");
+    check_type(context, 0, "extended_asset[]",
+               R"([{"quantity":"0 FOO","contract":"bar"},{"quantity":"0.123456 SIX","contract":"seven"}])");
+    check_error(context, "Stream overrun", [&] {
+        return abieos_hex_to_json(context, 0, "extended_asset[]", "02000000000000000000464F4F00000000000000000000AE39");
+    });
+    check_error(context, "Stream overrun", [&] {
+        return abieos_hex_to_json(context, 0, "extended_asset", "0000000000000000464F4F00000000000000000000AE39");
+    });
+    check_error(context, "Expected field", [&] {
+        return abieos_json_to_bin(context, 0, "extended_asset[]", R"([{"contract":"bar","quantity":"0 FOO"}])");
+    });
+    check_error(context, "Stream overrun", [&] {
+        return abieos_bin_size(context, abieos_resolve_type(context, 0, "extended_asset[]"), "\x02", 1, nullptr);
+    });
 
     check_type(context, token, "transfer",
                R"({"from":"useraaaaaaaa","to":"useraaaaaaab","quantity":"0.0001 SYS","memo":"test memo"})");
@@ -1238,6 +1287,565 @@ void check_types() {
     // check uint8[][][]
     check_type(context, 0, "uint8[][][]", R"([[[1,2,3],[4,5,6]],[[7,8,9],[]]])");
 
+    // check arrays whose sizes take more than one byte
+    std::string long_arrays = "[";
+    for (int i = 0; i < 130; ++i) {
+        long_arrays += i ? ",[" : "[";
+        for (int j = 0; j < (i == 2 ? 300 : i % 3); ++j)
+            long_arrays += (j ? "," : "") + std::to_string(j % 256);
+        long_arrays += "]";
+    }
+    long_arrays += "]";
+    check_type(context, 0, "uint8[][]", long_arrays.c_str());
+
+    // check type handles
+    auto transfer = check_context(context, abieos_resolve_type(context, token, "transfer"));
+    const char* transfer_json = R"({"from":"useraaaaaaaa","to":"useraaaaaaab","quantity":"0.0001 SYS","memo":"test memo"})";
+    check_context(context, abieos_json_to_bin_by_handle(context, transfer, transfer_json));
+    std::string transfer_hex = check_context(context, abieos_get_bin_hex(context));
+    std::string unhex_error;
+    check(check_context(context, abieos_hex_to_json_by_handle(context, transfer, transfer_hex.c_str())) ==
+              std::string{transfer_json},
+          "hex_to_json_by_handle");
+    check(check_context(context, abieos_hex_to_json(context, token, "transfer", transfer_hex.c_str())) ==
+              std::string{transfer_json},
+          "hex_to_json matches by_handle");
+    check_context(context, abieos_json_to_bin_reorderable_by_handle(
+                               context, transfer, R"({"to":"useraaaaaaab","memo":"test memo","from":"useraaaaaaaa","quantity":"0.0001 SYS"})"));
+    check(check_context(context, abieos_get_bin_hex(context)) == transfer_hex, "json_to_bin_reorderable_by_handle");
+    check_context(context, abieos_json_to_bin_reorderable(
+                               context, token, "transfer", R"({"memo":"x","to":"useraaaaaaab","extra":[{}],"from":"useraaaaaaaa","quantity":"0.0001 SYS","memo":"test memo"})"));
+    check(check_context(context, abieos_get_bin_hex(context)) == transfer_hex,
+          "json_to_bin_reorderable ignores unknown keys and keeps the last of repeated keys");
+    check_error(context, "Unknown type of nosuchtype",
+                [&] { return abieos_resolve_type(context, token, "nosuchtype"); });
+    check_error(context, "type handle is null",
+                [&] { return abieos_bin_to_json_by_handle(context, nullptr, "", 0); });
+
+    // check in-place json parsing
+    std::string insitu{transfer_json};
+    insitu.append(3, '\0');
+    check_context(context, abieos_json_to_bin_insitu(context, token, "transfer", insitu.data(), strlen(transfer_json)));
+    check(check_context(context, abieos_get_bin_hex(context)) == transfer_hex, "json_to_bin_insitu");
+    insitu.assign(transfer_json).append(3, '\0');
+    check_context(context, abieos_json_to_bin_by_handle_insitu(context, transfer, insitu.data(), strlen(transfer_json)));
+    check(check_context(context, abieos_get_bin_hex(context)) == transfer_hex, "json_to_bin_by_handle_insitu");
+    char unpadded[] = "{}\0";
+    check_error(context, "json must be followed by 3 zero bytes",
+                [&] { return abieos_json_to_bin_insitu(context, token, "transfer", unpadded, 1); });
+    auto insitu_contract = check_context(context, abieos_string_to_name(context, "insitu"));
+    insitu.assign(transactionAbi).append(3, '\0');
+    check_context(context, abieos_set_abi_insitu(context, insitu_contract, insitu.data(), strlen(transactionAbi)));
+    check_context(context, abieos_resolve_type(context, insitu_contract, "transaction"));
+
+    // check batch conversion
+    std::vector<char> transfer_bin;
+    check(abieos::unhex(unhex_error, transfer_hex.begin(), transfer_hex.end(), std::back_inserter(transfer_bin)));
+    abieos_batch_item bin_items[] = {
+        {token, "transfer", nullptr, transfer_bin.data(), transfer_bin.size()},
+        {0, nullptr, transfer, transfer_bin.data(), transfer_bin.size()},
+        {token, "transfer", nullptr, transfer_bin.data(), 3},
+        {0, "uint16", nullptr, "\x34\x12", 2},
+    };
+    abieos_batch_result bin_results[4];
+    check(!abieos_bin_to_json_batch(context, bin_items, 4, bin_results), "bin_to_json_batch reports failure");
+    const char* batch_data = abieos_get_batch_data(context);
+    check(bin_results[0].ok && std::string(batch_data + bin_results[0].offset, bin_results[0].size) == transfer_json,
+          "bin_to_json_batch item 0");
+    check(bin_results[1].ok && std::string(batch_data + bin_results[1].offset) == transfer_json,
+          "bin_to_json_batch item 1");
+    check(!bin_results[2].ok && std::string(batch_data + bin_results[2].offset) == abieos_get_error(context),
+          "bin_to_json_batch item 2");
+    check(bin_results[3].ok && std::string(batch_data + bin_results[3].offset) == "4660", "bin_to_json_batch item 3");
+
+    abieos_batch_item json_items[] = {
+        {0, nullptr, transfer, transfer_json, 0},
+        {0, "uint16", nullptr, "4660", 0},
+    };
+    abieos_batch_result json_results[2];
+    check_context(context, abieos_json_to_bin_batch(context, json_items, 2, json_results));
+    batch_data = abieos_get_batch_data(context);
+    check(abieos::hex(batch_data + json_results[0].offset, batch_data + json_results[0].offset + json_results[0].size) ==
+              transfer_hex,
+          "json_to_bin_batch item 0");
+    check(std::string(batch_data + json_results[1].offset, json_results[1].size) == "\x34\x12", "json_to_bin_batch item 1");
+
+    // check conversions into caller buffers
+    char out[256];
+    size_t needed = 0;
+    check(!abieos_bin_to_json_into(context, token, "transfer", transfer_bin.data(), transfer_bin.size(), out, 10,
+                                   &needed),
+          "bin_to_json_into reports a short buffer");
+    check(needed == strlen(transfer_json) && abieos_get_error(context) == std::string{"output buffer is too small"},
+          "bin_to_json_into reports the needed size");
+    check_context(context, abieos_bin_to_json_by_handle_into(context, transfer, transfer_bin.data(),
+                                                             transfer_bin.size(), out, needed, &needed));
+    check(std::string(out, needed) == transfer_json, "bin_to_json_by_handle_into");
+    check(!abieos_json_to_bin_into(context, token, "transfer", transfer_json, nullptr, 0, &needed) &&
+              needed == transfer_bin.size(),
+          "json_to_bin_into size query");
+    check_context(context, abieos_json_to_bin_by_handle_into(context, transfer, transfer_json, out, sizeof(out),
+                                                             &needed));
+    check(std::vector<char>(out, out + needed) == transfer_bin, "json_to_bin_by_handle_into");
+    check_context(context,
+                  abieos_json_to_bin_into(context, 0, "uint8[][]", "[[1,2],[],[3]]", out, sizeof(out), &needed));
+    check(abieos::hex(out, out + needed) == "03020102000103", "json_to_bin_into with arrays");
+    check_error(context, "contract \"nosuchcontr\" is not loaded", [&] {
+        return abieos_bin_to_json_into(context, abieos_string_to_name(context, "nosuchcontr"), "transfer",
+                                       transfer_bin.data(), transfer_bin.size(), out, sizeof(out), &needed);
+    });
+
+    abieos_destroy(context);
+}
+
+void check_shared_registry() {
+    const char* json = R"({"account":"eosio.token","name":"transfer","authorization":[{"actor":"useraaaaaaaa","permission":"active"}],"data":"00"})";
+    auto registry = check(abieos_create_registry());
+    auto writer = check(abieos_create_with_registry(registry));
+    check_context(writer, abieos_set_abi(writer, 0, transactionAbi));
+
+    std::vector<std::thread> readers;
+    std::vector<std::string> errors(4);
+    for (auto& error : errors) {
+        auto context = check(abieos_create_with_registry(registry));
+        readers.emplace_back([context, json, &error] {
+            try {
+                for (int i = 0; i < 200; ++i) {
+                    check_context(context, abieos_json_to_bin(context, 0, "action", json));
+                    std::string hex = check_context(context, abieos_get_bin_hex(context));
+                    if (check_context(context, abieos_hex_to_json(context, 0, "action", hex.c_str())) != std::string{json})
+                        throw std::runtime_error("mismatch");
+                    check_context(context, abieos_json_to_bin(context, 0, "permission_level[]", "[]"));
+                }
+            } catch (std::exception& e) {
+                error = e.what();
+            }
+            abieos_destroy(context);
+        });
+    }
+    for (int i = 0; i < 50; ++i) {
+        abieos_set_lazy_abis(writer, i & 1);
+        check_context(writer, abieos_set_abi(writer, 0, transactionAbi));
+    }
+    for (auto& t : readers)
+        t.join();
+    for (auto& error : errors)
+        if (!error.empty())
+            throw std::runtime_error("shared registry: " + error);
+
+    auto other = check(abieos_create_with_registry(registry));
+    abieos_destroy_registry(registry);
+    check(abieos_delete_contract(writer, 0), "delete shared contract");
+    check(!abieos_json_to_bin(other, 0, "action", json), "deleted contract is not visible");
+    abieos_destroy(other);
+    abieos_destroy(writer);
+}
+
+void check_abi_dedup() {
+    auto context = check(abieos_create());
+    check_context(context, abieos_abi_json_to_bin(context, transactionAbi));
+    std::string bin(abieos_get_bin_data(context), abieos_get_bin_size(context));
+    check_context(context, abieos_set_abi_bin(context, 1, bin.data(), bin.size()));
+    check_context(context, abieos_set_abi_bin(context, 2, bin.data(), bin.size()));
+    check_context(context, abieos_set_abi(context, 3, transactionAbi));
+    check_context(context, abieos_set_abi(context, 4, packedTransactionAbi));
+    auto action = check_context(context, abieos_resolve_type(context, 1, "action"));
+    check(check_context(context, abieos_resolve_type(context, 2, "action")) == action, "identical abis are shared");
+    check(check_context(context, abieos_resolve_type(context, 3, "action")) == action, "json abis are shared");
+    check(check_context(context, abieos_resolve_type(context, 4, "action")) != action, "different abis are not shared");
+    check_context(context, abieos_delete_contract(context, 1));
+    check_context(context, abieos_json_to_bin(context, 2, "permission_level", R"({"actor":"a","permission":"b"})"));
+    check(check_context(context, abieos_resolve_type(context, 2, "action")) == action, "shared abi survives delete");
+    abieos_set_lazy_abis(context, true);
+    check_context(context, abieos_set_abi_bin(context, 5, bin.data(), bin.size()));
+    check(check_context(context, abieos_resolve_type(context, 5, "action")) != action,
+          "lazy abis are not shared with eager ones");
+    abieos_destroy(context);
+}
+
+void check_memory_budget() {
+    auto context = check(abieos_create());
+    auto wait = [] { std::this_thread::sleep_for(std::chrono::milliseconds(2)); };
+    check_context(context, abieos_set_abi(context, 1, transactionAbi));
+    wait();
+    check_context(context, abieos_set_abi(context, 2, packedTransactionAbi));
+    wait();
+    check_context(context, abieos_set_abi(context, 3, testAbi));
+    check_context(context, abieos_set_abi(context, 4, testAbi));
+    auto m1 = check_context(context, abieos_get_contract_memory(context, 1));
+    auto m2 = check_context(context, abieos_get_contract_memory(context, 2));
+    auto m3 = check_context(context, abieos_get_contract_memory(context, 3));
+    check(m1 > strlen(transactionAbi) / 4 && m2 > m1, "contract memory");
+    check(abieos_get_contract_memory(context, 4) == m3, "shared abis report their full size");
+    check(abieos_get_total_memory(context) == m1 + m2 + m3, "shared abis count once in the total");
+
+    wait();
+    check_context(context, abieos_json_to_bin(context, 1, "permission_level", R"({"actor":"a","permission":"b"})"));
+    std::vector<uint64_t> evicted;
+    abieos_set_memory_budget(
+        context, m1 + m3, [](void* data, uint64_t contract, uint32_t) { ((std::vector<uint64_t>*)data)->push_back(contract); },
+        &evicted);
+    check(evicted == std::vector<uint64_t>{2}, "least recently used abi is evicted");
+    check(abieos_get_total_memory(context) == m1 + m3, "evicted memory is released");
+    check_error(context, "contract \"............2\" is not loaded",
+                [&] { return abieos_resolve_type(context, 2, "transaction"); });
+
+    evicted.clear();
+    wait();
+    check_context(context, abieos_resolve_type(context, 3, "s1"));
+    check_context(context, abieos_set_abi(context, 2, packedTransactionAbi));
+    std::sort(evicted.begin(), evicted.end());
+    check(evicted == std::vector<uint64_t>{1, 3, 4}, "a new abi evicts the others to fit");
+    check_context(context, abieos_resolve_type(context, 2, "transaction"));
+    abieos_set_memory_budget(context, 0, nullptr, nullptr);
+    abieos_destroy(context);
+}
+
+void check_abi_history() {
+    const char* v1 = R"({"version":"flon::abi/1.1","structs":[{"name":"s","base":"","fields":[{"name":"a","type":"uint8"}]}],"actions":[{"name":"act","type":"s"}]})";
+    const char* v2 = R"({"version":"flon::abi/1.1","structs":[{"name":"s","base":"","fields":[{"name":"a","type":"uint8"},{"name":"b","type":"string"}]}],"actions":[{"name":"act2","type":"s"}]})";
+    auto context = check(abieos_create());
+    auto act = check_context(context, abieos_string_to_name(context, "act"));
+    check_context(context, abieos_set_abi_at(context, 5, 100, v1));
+    check_context(context, abieos_set_abi_at(context, 5, 200, v2));
+    check_error(context, "contract \"............5\" has no abi at block 99",
+                [&] { return abieos_json_to_bin_at(context, 5, 99, "s", R"({"a":1})"); });
+    for (uint32_t block_num : {100, 199}) {
+        check_context(context, abieos_json_to_bin_at(context, 5, block_num, "s", R"({"a":1})"));
+        check(check_context(context, abieos_get_bin_hex(context)) == std::string{"01"}, "json_to_bin_at");
+    }
+    check(check_context(context, abieos_get_type_for_action_at(context, 5, 150, act)) == std::string{"s"},
+          "get_type_for_action_at");
+    check_error(context, "contract \"............5\" does not have action \"act\"",
+                [&] { return abieos_get_type_for_action(context, 5, act); });
+    check(check_context(context, abieos_bin_to_json_at(context, 5, 300, "s", "\x01\x01x", 3)) ==
+              std::string{R"({"a":1,"b":"x"})"},
+          "bin_to_json_at");
+    check_context(context, abieos_json_to_bin(context, 5, "s", R"({"a":1,"b":"x"})"));
+    check(check_context(context, abieos_get_bin_hex(context)) == std::string{"010178"}, "latest abi is the default");
+
+    auto* t = check_context(context, abieos_resolve_type_at(context, 5, 150, "s"));
+    check_context(context, abieos_json_to_bin_by_handle(context, t, R"({"a":2})"));
+    check(check_context(context, abieos_get_bin_hex(context)) == std::string{"02"}, "resolve_type_at");
+    check_error(context, "no data", [&] { return abieos_set_abi_bin_at(context, 5, 100, nullptr, 0); });
+    check_context(context, abieos_set_abi_at(context, 5, 100, v2));
+    check_context(context, abieos_json_to_bin_at(context, 5, 150, "s", R"({"a":2,"b":""})"));
+    check(abieos_get_total_memory(context) == abieos_get_contract_memory(context, 5), "versions share one abi");
+
+    check_context(context, abieos_set_abi(context, 5, v1));
+    check_context(context, abieos_json_to_bin_at(context, 5, 0, "s", R"({"a":1})"));
+    check_context(context, abieos_json_to_bin_at(context, 5, 300, "s", R"({"a":1})"));
+    abieos_destroy(context);
+}
+
+void check_lazy_abis() {
+    const char* abi = R"({"version":"flon::abi/1.1","types":[{"new_type_name":"ids","type":"uint64[]"},{"new_type_name":"bad","type":"nosuchtype"}],"structs":[{"name":"s","base":"","fields":[{"name":"a","type":"ids"},{"name":"b","type":"s?"}]},{"name":"broken","base":"","fields":[{"name":"x","type":"bad"}]}]})";
+    auto context = check(abieos_create());
+    check_error(context, "Unknown type of nosuchtype", [&] { return abieos_set_abi(context, 0, abi); });
+    abieos_set_lazy_abis(context, true);
+    check_context(context, abieos_set_abi(context, 0, abi));
+    run_check_type(context, 0, "s", R"({"a":["1","2"],"b":{"a":[],"b":null}})");
+    run_check_type(context, 0, "ids", R"(["3"])");
+    check_error(context, "Unknown type of nosuchtype", [&] { return abieos_json_to_bin(context, 0, "broken", "{}"); });
+    for (int i = 0; i < 2; ++i)
+        check_error(context, "Unknown type of nosuchtype", [&] { return abieos_json_to_bin(context, 0, "broken[]", "[]"); });
+    check_error(context, "Unknown type of nosuchtype", [&] { return abieos_validate_abi(context, 0); });
+    check_context(context, abieos_set_abi(context, 1, transactionAbi));
+    check_context(context, abieos_validate_abi(context, 1));
+
+    // types resolved on demand are accounted as they are added, to the same total a full recount gives
+    const char* small = R"({"version":"flon::abi/1.1","structs":[{"name":"s","base":"","fields":[{"name":"a","type":"uint64[]"},{"name":"b","type":"s?"}]}]})";
+    check_context(context, abieos_set_abi(context, 2, small));
+    auto unresolved = abieos_get_contract_memory(context, 2);
+    run_check_type(context, 2, "s", R"({"a":["1"],"b":null})");
+    auto resolved = abieos_get_contract_memory(context, 2);
+    check_context(context, abieos_validate_abi(context, 2));
+    check(resolved > unresolved && abieos_get_contract_memory(context, 2) >= resolved, "lazy type accounting");
+    resolved = abieos_get_contract_memory(context, 2);
+    run_check_type(context, 2, "s[]?", R"([{"a":[],"b":null}])");
+    auto derived = abieos_get_contract_memory(context, 2);
+    check_context(context, abieos_validate_abi(context, 2));
+    check(derived > resolved && abieos_get_contract_memory(context, 2) == derived, "derived type accounting");
+    abieos_destroy(context);
+}
+
+void check_abi_cache() {
+    const char* json = R"({"account":"eosio.token","name":"transfer","authorization":[],"data":"00"})";
+    auto path = (std::filesystem::temp_directory_path() / "test_flon_abi.cache").string();
+    auto context = check(abieos_create());
+    check_context(context, abieos_abi_json_to_bin(context, transactionAbi));
+    std::string transaction_abi(abieos_get_bin_data(context), abieos_get_bin_size(context));
+    check_context(context, abieos_abi_json_to_bin(context, testAbi));
+    std::string test_abi(abieos_get_bin_data(context), abieos_get_bin_size(context));
+
+    abieos_abi_cache_item items[] = {
+        {2, test_abi.data(), test_abi.size()},
+        {1, transaction_abi.data(), transaction_abi.size()},
+        {5, transaction_abi.data(), transaction_abi.size()},
+    };
+    check_context(context, abieos_write_abi_cache(context, path.c_str(), items, 3));
+    check(std::filesystem::file_size(path) == 16 + 3 * 24 + test_abi.size() + transaction_abi.size(),
+          "abi cache stores identical abis once");
+    items[0].contract = 1;
+    check_error(context, "contract \"............1\" is in the abi cache more than once",
+                [&] { return abieos_write_abi_cache(context, path.c_str(), items, 2); });
+    items[1] = {3, "\x03" "abc", 4};
+    check_error(context, "unsupported abi version",
+                [&] { return abieos_write_abi_cache(context, path.c_str(), items, 2); });
+
+    auto loaded = check(abieos_create());
+    check_context(loaded, abieos_set_abi(loaded, 1, testAbi));
+    check_context(loaded, abieos_load_abi_cache(loaded, path.c_str()));
+    check_context(loaded, abieos_json_to_bin(loaded, 1, "action", json));
+    std::string hex = check_context(loaded, abieos_get_bin_hex(loaded));
+    check(check_context(loaded, abieos_hex_to_json(loaded, 1, "action", hex.c_str())) == std::string{json},
+          "abi cache round trip");
+    check_context(loaded, abieos_resolve_type(loaded, 2, "v1"));
+    check(check_context(loaded, abieos_resolve_type(loaded, 5, "action")) ==
+              check_context(loaded, abieos_resolve_type(loaded, 1, "action")),
+          "abi cache shares identical abis");
+    check_error(loaded, std::string{"can't open "} + path + ".missing: No such file or directory",
+                [&] { return abieos_load_abi_cache(loaded, (path + ".missing").c_str()); });
+    std::filesystem::remove(path);
+    abieos_destroy(loaded);
+    abieos_destroy(context);
+}
+
+// Returns each token of json, or the error, as read with tokenizer
+std::string read_json_tokens(std::string json, eosio::json_tokenizer tokenizer) {
+    std::string result;
+    try {
+        eosio::json_token_stream stream(json.data(), tokenizer);
+        do {
+            auto& t = stream.peek_token().get();
+            if (t.type == eosio::json_token_type::type_unread)
+                break;
+            result += std::to_string(int(t.type)) + ":";
+            if (t.type == eosio::json_token_type::type_key)
+                result += t.key;
+            else if (t.type == eosio::json_token_type::type_string)
+                result += t.value_string;
+            else if (t.type == eosio::json_token_type::type_bool)
+                result += t.value_bool ? "true" : "false";
+            result += "\n";
+            stream.eat_token();
+        } while (!stream.complete());
+    } catch (std::exception& e) {
+        return std::string("error: ") + e.what();
+    }
+    return result;
+}
+
+void check_json_tokenizers() {
+    std::vector<std::string> docs = {
+        R"({"a":1,"b":[true,false,null],"c":{"d":"e\"f\\g\/\b\f\n\r\t\u00e9\ud83d\ude00"}})",
+        " [ -1.5e+10 , 0 , -0.25E-3, \"\" , [ ] , { } ]\n",
+        "\"caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\"",
+        "\"\\\\\"",
+        "7",
+        "",
+        " ",
+        "[1 2]",
+        R"({"a" 1})",
+        R"({"a":1 "b":2})",
+        "{1:2}",
+        R"({"a":1,})",
+        "[1,]",
+        R"({"a":})",
+        "[1}",
+        "\"abc",
+        R"("\x")",
+        R"("\u12g4")",
+        R"("\ud800x")",
+        "\"\xff\"",
+        "\"\xc0\x80\"",
+        "\"\xed\xa0\x80\"",
+        "\"a\x01\"",
+        "true x",
+        "01",
+        "[truex]",
+        "[tru]",
+        "-",
+        "1.",
+        "1e+",
+        "{\"a\":[1,{\"b\":\"c\"}]}}",
+    };
+    // strings, escapes and scalars straddling the 64-byte blocks of the structural index
+    for (size_t n = 50; n < 140; n += 7) {
+        std::string doc = "[" + std::string(n, ' ') + "\"" + std::string(n, 'x') + "\\\\\\\"" + "\"," +
+                          std::string(n % 13, '1') + "," + "\"" + std::string(n, '\\').substr(0, n & ~1) + "\"]";
+        docs.push_back(doc);
+        docs.push_back(doc.substr(0, doc.size() - n / 3));
+    }
+    for (auto& doc : docs) {
+        auto expected = read_json_tokens(doc, eosio::json_tokenizer::rapidjson);
+        auto result   = read_json_tokens(doc, eosio::json_tokenizer::structural);
+        if (result != expected)
+            throw std::runtime_error("tokenizers disagree on " + doc + "\n" + expected + "\n" + result);
+    }
+
+    const char  alphabet[] = "{}[]:, \t\r\n\"\\ab0\x01\x80\xff";
+    std::string bytes;
+    for (int i = 0; i < 1000; ++i)
+        bytes.push_back(alphabet[(i * 7919 + i / 3) % (sizeof(alphabet) - 1)]);
+    eosio::json_structural_index simd, scalar;
+    simd.build(bytes.data(), bytes.size());
+    scalar.build_with<eosio::json_classify_scalar>(bytes.data(), bytes.size());
+    check(simd.count == scalar.count && std::equal(simd.positions.begin(), simd.positions.begin() + simd.count,
+                                                   scalar.positions.begin()) &&
+              simd.quotes == scalar.quotes && simd.specials == scalar.specials,
+          "simd and scalar structural indexes agree");
+}
+
+void check_projections() {
+    const char* abi = R"({"version":"flon::abi/1.1","structs":[{"name":"p","base":"","fields":[{"name":"a","type":"uint8"},{"name":"b","type":"string[]"},{"name":"c","type":"q?"},{"name":"d","type":"v[]"},{"name":"e","type":"uint8$"}]},{"name":"q","base":"","fields":[{"name":"x","type":"uint8"},{"name":"y","type":"string"}]}],"variants":[{"name":"v","types":["q","uint8"]}]})";
+    auto context = check(abieos_create());
+    check_context(context, abieos_set_abi(context, 0, abi));
+    auto* type = check_context(context, abieos_resolve_type(context, 0, "p"));
+    auto project = [&](std::vector<const char*> paths, const char* json, const char* expected) {
+        check_context(context, abieos_json_to_bin(context, 0, "p", json));
+        std::string bin(abieos_get_bin_data(context), abieos_get_bin_size(context));
+        auto* projection = check_context(context, abieos_create_projection(context, type, paths.data(), paths.size()));
+        std::string result = check_context(context, abieos_bin_to_json_projected(context, projection, bin.data(), bin.size()));
+        abieos_destroy_projection(projection);
+        if (result != expected)
+            throw std::runtime_error("projection mismatch: " + result + " != " + expected);
+    };
+    const char* full = R"({"a":1,"b":["s","t"],"c":{"x":2,"y":"z"},"d":[["q",{"x":3,"y":"w"}],["uint8",4]],"e":5})";
+    project({"d[].x", "a"}, full, R"({"a":1,"d":[["q",{"x":3}],["uint8",null]]})");
+    project({"c.y", "e", "b"}, full, R"({"b":["s","t"],"c":{"y":"z"},"e":5})");
+    project({"d[]", "d[].y"}, full, R"({"d":[["q",{"x":3,"y":"w"}],["uint8",4]]})");
+    project({"c.y", "e"}, R"({"a":1,"b":[],"c":null,"d":[]})", R"({"c":null})");
+    for (auto* path : {"c.z", "b.x", "d.x", "a.", "", "d[]x"}) {
+        std::vector<const char*> paths{path};
+        check_error(context, "Bad projection",
+                    [&] { return abieos_create_projection(context, type, paths.data(), paths.size()); });
+    }
+    abieos_destroy(context);
+}
+
+void check_binary_formats() {
+    const char* abi = R"({"version":"flon::abi/1.1","structs":[{"name":"q","base":"","fields":[{"name":"x","type":"uint8"},{"name":"y","type":"string"}]},{"name":"r","base":"","fields":[{"name":"a","type":"uint8"},{"name":"b","type":"int32"},{"name":"c","type":"string"},{"name":"d","type":"bytes"},{"name":"e","type":"name"},{"name":"f","type":"uint16[]"},{"name":"g","type":"float64"},{"name":"h","type":"q?"},{"name":"i","type":"v"},{"name":"j","type":"uint64"},{"name":"k","type":"int8$"}]}],"variants":[{"name":"v","types":["q","uint8"]}]})";
+    auto context = check(abieos_create());
+    check_context(context, abieos_set_abi(context, 0, abi));
+    auto convert = [&](const char* json, const char* msgpack, const char* cbor) {
+        check_context(context, abieos_json_to_bin(context, 0, "r", json));
+        std::string bin(abieos_get_bin_data(context), abieos_get_bin_size(context));
+        check_context(context, abieos_bin_to_msgpack(context, 0, "r", bin.data(), bin.size()));
+        if (std::string(check_context(context, abieos_get_bin_hex(context))) != msgpack)
+            throw std::runtime_error(std::string("msgpack mismatch: ") + json);
+        check_context(context, abieos_bin_to_cbor(context, 0, "r", bin.data(), bin.size()));
+        if (std::string(check_context(context, abieos_get_bin_hex(context))) != cbor)
+            throw std::runtime_error(std::string("cbor mismatch: ") + json);
+    };
+    convert(R"({"a":200,"b":-70000,"c":"hi","d":"0A0B","e":"eosio","f":[1,300],"g":1.5,"h":null,"i":["q",{"x":3,"y":"w"}],"j":"5000000000","k":-5})",
+            "8BA161CCC8A162D2FFFEEE90A163A26869A164C4020A0BA165A5656F73696FA1669201CD012CA167CB3FF8000000000000A168C0A169"
+            "92A17182A17803A179A177A16ACF000000012A05F200A16BFB",
+            "AB616118C861623A0001116F61636268696164420A0B616565656F73696F6166820119012C6167FB3FF80000000000006168F66169"
+            "826171A261780361796177616A1B000000012A05F200616B24");
+    // k, an extension, is left out of the map
+    convert(R"({"a":0,"b":0,"c":"","d":"","e":"","f":[],"g":-0.25,"h":{"x":1,"y":"z"},"i":["uint8",7],"j":"0"})",
+            "8AA16100A16200A163A0A164C400A165A0A16690A167CBBFD0000000000000A16882A17801A179A17AA16992A575696E743807A16A00",
+            "AA6161006162006163606164406165606166806167FBBFD00000000000006168A26178016179617A6169826575696E743807616A00");
+    check_error(context, "Stream overrun", [&] { return abieos_bin_to_cbor(context, 0, "r", "\x01", 1); });
+    abieos_destroy(context);
+}
+
+void check_columns() {
+    const char* abi = R"({"version":"flon::abi/1.1","structs":[{"name":"row","base":"","fields":[{"name":"id","type":"uint64"},{"name":"memo","type":"string"},{"name":"tags","type":"string[]"},{"name":"bal","type":"asset?"},{"name":"grid","type":"uint16[][]"},{"name":"n","type":"varuint32"},{"name":"v","type":"v"},{"name":"ext","type":"uint32$"}]}],"variants":[{"name":"v","types":["uint8","string"]}]})";
+    auto context = check(abieos_create());
+    check_context(context, abieos_set_abi(context, 0, abi));
+    auto* columns = check_context(context, abieos_create_columns(context, abieos_resolve_type(context, 0, "row")));
+    std::vector<std::string> rows;
+    for (auto* json : {R"({"id":"1","memo":"hi","tags":["a","bc"],"bal":"1.0000 SYS","grid":[[1,2],[3]],"n":300,"v":["uint8",5],"ext":7})",
+                       R"({"id":"2","memo":"","tags":[],"bal":null,"grid":[],"n":1,"v":["string","x"]})"}) {
+        check_context(context, abieos_json_to_bin(context, 0, "row", json));
+        rows.emplace_back(abieos_get_bin_data(context), abieos_get_bin_size(context));
+    }
+    std::vector<const char*> data;
+    std::vector<size_t> sizes;
+    for (auto& row : rows) {
+        data.push_back(row.data());
+        sizes.push_back(row.size());
+    }
+    check_context(context, abieos_append_columns(context, columns, data.data(), sizes.data(), data.size()));
+    sizes[0] = 3;
+    check_error(context, "Stream overrun",
+                [&] { return abieos_append_columns(context, columns, data.data(), sizes.data(), 1); });
+    check(abieos_get_row_count(columns) == 2, "row count");
+
+    std::vector<std::string> expected = {
+        "id 0 8 -1 0 2 01000000000000000200000000000000",
+        "memo 1 0 -1 0 2 6869 0,2,2",
+        "tags 2 0 -1 0 2  0,2,2",
+        "tags[] 1 0 2 0 2 616263 0,1,3",
+        "bal 0 16 -1 1 2 1027000000000000045359530000000000000000000000000000000000000000 1,0",
+        "grid 2 0 -1 0 2  0,2,2",
+        "grid[] 2 0 5 0 2  0,2,3",
+        "grid[][] 0 2 6 0 3 010002000300",
+        "n 0 4 -1 0 2 2C01000001000000",
+        "v 1 0 -1 0 2 0005010178 0,2,5",
+        "ext 0 4 -1 1 2 0700000000000000 1,0",
+    };
+    check(abieos_get_column_count(columns) == expected.size(), "column count");
+    for (size_t i = 0; i < expected.size(); ++i) {
+        abieos_column column;
+        check_context(context, abieos_get_column(context, columns, i, &column));
+        std::string result = std::string(column.name) + " " + std::to_string(column.kind) + " " +
+                             std::to_string(column.width) + " " + std::to_string(column.parent) + " " +
+                             std::to_string(column.nullable) + " " + std::to_string(column.size) + " ";
+        std::vector<char> hex;
+        abieos::hex(column.data, column.data + column.data_size, std::back_inserter(hex));
+        result.append(hex.begin(), hex.end());
+        for (uint64_t j = 0; column.offsets && j <= column.size; ++j)
+            result += (j ? "," : " ") + std::to_string(column.offsets[j]);
+        for (uint64_t j = 0; column.validity && j < column.size; ++j)
+            result += (j ? "," : " ") + std::to_string(column.validity[j]);
+        if (result != expected[i])
+            throw std::runtime_error("column mismatch: " + result + " != " + expected[i]);
+    }
+    abieos_clear_columns(columns);
+    check(abieos_get_row_count(columns) == 0, "cleared row count");
+    abieos_destroy_columns(columns);
+    abieos_destroy(context);
+}
+
+void check_escaped_keys() {
+    const char* abi = R"({"version":"flon::abi/1.1","structs":[{"name":"s","base":"","fields":[{"name":"a\"b","type":"uint8"},{"name":"c\\d","type":"uint8[]"},{"name":"\u0001","type":"v"}]}],"variants":[{"name":"v","types":["uint8"]}]})";
+    auto context = check(abieos_create());
+    check_context(context, abieos_set_abi(context, 0, abi));
+    const char* json = R"({"a\"b":1,"c\\d":[2],"\u0001":["uint8",3]})";
+    check_context(context, abieos_json_to_bin(context, 0, "s", json));
+    std::string hex = check_context(context, abieos_get_bin_hex(context));
+    std::string result = check_context(context, abieos_hex_to_json(context, 0, "s", hex.c_str()));
+    if (result != json)
+        throw std::runtime_error("escaped keys mismatch: " + result);
+    abieos_destroy(context);
+}
+
+void check_pseudo_serializers() {
+    const char* abi = R"({"version":"flon::abi/1.1","structs":[{"name":"s","base":"","fields":[{"name":"a","type":"uint8"},{"name":"b","type":"v[]"},{"name":"c","type":"string$"}]}],"variants":[{"name":"v","types":["s","uint16"]}]})";
+    auto context = check(abieos_create());
+    check_context(context, abieos_set_abi(context, 0, abi));
+    // The serializers of composite types run the type's whole program when called on their own
+    auto convert = [&](const char* name, const std::string& json) {
+        auto* type = reinterpret_cast<const eosio::abi_type*>(check_context(context, abieos_resolve_type(context, 0, name)));
+        std::string json_copy = json + std::string(3, '\0');
+        std::vector<char> bin;
+        eosio::vector_stream writer{bin};
+        abieos::json_to_bin_state json_state(json_copy.data(), writer);
+        type->ser->json_to_bin(json_state, true, type, true);
+        std::vector<char> result;
+        eosio::vector_stream result_writer{result};
+        eosio::input_stream input{bin.data(), bin.size()};
+        abieos::bin_to_json_state bin_state{input, result_writer};
+        type->ser->bin_to_json(bin_state, true, type);
+        if (input.remaining() || std::string(result.data(), result.size()) != json)
+            throw std::runtime_error("pseudo serializer mismatch: " + std::string(result.data(), result.size()));
+    };
+    convert("s", R"({"a":1,"b":[["s",{"a":2,"b":[["uint16",3]],"c":"y"}]],"c":"x"})");
+    convert("v[]", R"([["uint16",4],["s",{"a":5,"b":[],"c":""}]])");
+    convert("v", R"(["s",{"a":6,"b":[]}])");
     abieos_destroy(context);
 }
 
@@ -1245,6 +1853,30 @@ int main() {
     try {
         check_types();
         printf("\ncheck_types ok\n\n");
+        check_shared_registry();
+        printf("check_shared_registry ok\n\n");
+        check_abi_dedup();
+        printf("check_abi_dedup ok\n\n");
+        check_memory_budget();
+        printf("check_memory_budget ok\n\n");
+        check_abi_history();
+        printf("check_abi_history ok\n\n");
+        check_lazy_abis();
+        printf("check_lazy_abis ok\n\n");
+        check_abi_cache();
+        printf("check_abi_cache ok\n\n");
+        check_json_tokenizers();
+        printf("check_json_tokenizers ok\n\n");
+        check_projections();
+        printf("check_projections ok\n\n");
+        check_binary_formats();
+        printf("check_binary_formats ok\n\n");
+        check_columns();
+        printf("check_columns ok\n\n");
+        check_escaped_keys();
+        printf("check_escaped_keys ok\n\n");
+        check_pseudo_serializers();
+        printf("check_pseudo_serializers ok\n\n");
         return 0;
     } catch (std::exception& e) {
         printf("error: %s\n", e.what());
@@ -0,0 +1,97 @@
+//
+// Purpose: build an abi cache file (see abieos_load_abi_cache) from a directory of ABIs
+//   each file's name, without its extension, is the contract account: eosio.token.abi holds eosio.token's ABI
+//   .abi and .json files hold json ABIs, .bin files binary ABIs
+//
+
+#include "abieos.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using unique_abieos = std::unique_ptr<abieos_context, decltype(&abieos_destroy)>;
+
+// prints usage
+void help(const char* exec_name) {
+    std::cerr << "Usage " << exec_name << ": -o CACHE [-v] DIRECTORY\n";
+    std::cerr << "\t-o cache file to write\n";
+    std::cerr << "\t-v verbose, print each ABI added\n";
+    std::cerr << "\texample: build_abi_cache -o abis.cache ./abis\n" << std::endl;
+}
+
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream ifs(path, std::ios::in | std::ios::binary);
+    if (!ifs)
+        throw std::runtime_error("unable to read " + path.string());
+    return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+}
+
+// Returns the binary form of the ABI in path
+std::string read_abi(abieos_context* context, const std::filesystem::path& path) {
+    auto contents = read_file(path);
+    if (path.extension() == ".bin")
+        return contents;
+    if (!abieos_abi_json_to_bin(context, contents.c_str()))
+        throw std::runtime_error(path.string() + ": " + abieos_get_error(context));
+    return {abieos_get_bin_data(context), size_t(abieos_get_bin_size(context))};
+}
+
+int main(int argc, char* argv[]) {
+    std::string output;
+    bool verbose = false;
+    int opt;
+
+    try {
+        while ((opt = getopt(argc, argv, "vo:")) != -1) {
+            switch (opt) {
+            case 'o': output = optarg; break;
+            case 'v': verbose = true; break;
+            default:
+                help(*argv);
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (output.empty() || optind + 1 != argc) {
+            help(*argv);
+            exit(EXIT_FAILURE);
+        }
+
+        unique_abieos context(abieos_create(), &abieos_destroy);
+        if (!context)
+            throw std::runtime_error("unable to create context");
+
+        std::vector<std::filesystem::path> paths;
+        for (auto& entry : std::filesystem::directory_iterator(argv[optind])) {
+            auto ext = entry.path().extension();
+            if (entry.is_regular_file() && (ext == ".abi" || ext == ".json" || ext == ".bin"))
+                paths.push_back(entry.path());
+        }
+
+        std::vector<std::string> abis;
+        std::vector<abieos_abi_cache_item> items;
+        abis.reserve(paths.size());
+        for (auto& path : paths) {
+            auto account = path.stem().string();
+            uint64_t contract = abieos_string_to_name(context.get(), account.c_str());
+            if (abieos_name_to_string(context.get(), contract) != account)
+                throw std::runtime_error(path.string() + ": " + account + " is not a valid account name");
+            abis.push_back(read_abi(context.get(), path));
+            items.push_back({contract, abis.back().data(), abis.back().size()});
+            if (verbose)
+                std::cerr << account << ": " << abis.back().size() << " bytes" << std::endl;
+        }
+
+        if (!abieos_write_abi_cache(context.get(), output.c_str(), items.data(), items.size()))
+            throw std::runtime_error(abieos_get_error(context.get()));
+        if (verbose)
+            std::cerr << "wrote " << items.size() << " ABIs to " << output << std::endl;
+        return 0;
+    } catch (std::exception& e) {
+        std::cerr << "Could not build abi cache: " << e.what() << std::endl;
+        return 1;
+    }
+}